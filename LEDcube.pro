@@ -8,5 +8,5 @@ DEPENDPATH += .
 INCLUDEPATH += .
 
 # Input
-HEADERS += matrixwidget.h window.h
-SOURCES += matrixwidget.cpp main.cpp window.cpp
+HEADERS += matrixwidget.h window.h frustum.h voxelgrid.h exporter.h lattice.h animations.h bitplane.h compositor.h layers.h driver.h sequence.h plugins.h mesh.h automaton.h particles.h audio.h volume.h ledcube_plugin.h
+SOURCES += matrixwidget.cpp main.cpp window.cpp frustum.cpp voxelgrid.cpp exporter.cpp lattice.cpp animations.cpp bitplane.cpp compositor.cpp layers.cpp driver.cpp sequence.cpp plugins.cpp mesh.cpp automaton.cpp particles.cpp audio.cpp volume.cpp
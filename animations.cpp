@@ -0,0 +1,187 @@
+/*  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
+
+ > Animations shown on the cube, as functions of the LED position and
+ > the time, and loading of the point clouds some of them draw.
+
+ > Copyright (C) 2014 by Daniel Intskirveli, Gurpreet Singh, Christopher Zhang.
+
+ > animations.cpp - what is on and what is off.
+
+ > Written by: Daniel Intskirveli, Gurpreet Singh, Christopher Zhang, 2014.
+
+  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_ */
+
+#include "animations.h"
+#include <QFile>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+int waveHeight(int x, int z, int t, int yCubes) {
+    return round(sin(z/2 + t/100)*2)+ round(sin(x/2)*2) + yCubes/2;
+}
+
+bool waveIsOn(int x, int y, int z, int t, int xCubes, int yCubes, int zCubes) {
+    if (xCubes == 1 && yCubes == 1 && zCubes == 1) {
+        return true;
+    }
+    if(y == waveHeight(x, z, t, yCubes)) {
+        return true;
+    }
+    return false;
+}
+
+bool pointsAreOn(const std::vector<Vector3>& points, int x, int y, int z) {
+    // iterate the vector
+    for (std::vector<Vector3>::const_iterator it = points.begin() ; it != points.end(); ++it) {
+        Vector3 a = *it;
+        if (a.x == x && a.y == y && a.z == z)   // verify if the coordinate is in the vector
+            return true;
+    }
+    return false;
+}
+
+float parseFloat(const char* str, char** end) {
+    static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+                                      1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18 };
+    const char* p = str;
+    while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') {
+        p++;
+    }
+    bool negative = *p == '-';
+    if (*p == '-' || *p == '+') {
+        p++;
+    }
+
+    unsigned long long mantissa = 0;
+    int digits = 0;
+    int scale = 0;                                          // digits after the point
+    for (; *p >= '0' && *p <= '9'; p++, digits++) {
+        mantissa = mantissa*10 + (*p - '0');
+    }
+    if (*p == '.') {
+        for (p++; *p >= '0' && *p <= '9'; p++, digits++, scale++) {
+            mantissa = mantissa*10 + (*p - '0');
+        }
+    }
+    if (*p == 'e' || *p == 'E') {
+        const char* e = p + 1;
+        bool negativeExponent = *e == '-';
+        if (*e == '-' || *e == '+') {
+            e++;
+        }
+        if (*e >= '0' && *e <= '9') {
+            int exponent = 0;
+            for (; *e >= '0' && *e <= '9' && exponent < 1000; e++) {
+                exponent = exponent*10 + (*e - '0');
+            }
+            scale += negativeExponent ? exponent : -exponent;
+            p = e;
+        }
+    }
+    bool separated = *p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' || *p == '\0';
+    if (digits == 0 || digits > 15 || scale > 18 || scale < -18 || !separated) {
+        return strtof(str, end);
+    }
+
+    // up to 15 digits the mantissa and the power of ten are exact in a
+    // double. the quotient is rounded to a double and then to a float,
+    // which only differs from strtof() for numbers within a hair of
+    // halfway between two floats
+    double value = scale >= 0 ? mantissa / powers[scale] : mantissa * powers[-scale];
+    *end = (char*) p;
+    return (float) (negative ? -value : value);
+}
+
+bool loadXYZ(const QString& file, std::vector<Vector3>& points) {
+    // read the whole file at once and parse it in place, a line at a
+    // time. sequences have thousands of these files of several MB each,
+    // going through QTextStream and a QString for every line is too slow.
+    QFile sfile(file);
+    if(!sfile.open(QFile::ReadOnly)) {
+        return false;
+    }
+    QByteArray data = sfile.readAll();
+    sfile.close();
+
+    // QByteArray keeps a '\0' after the data, so parsing stops there
+    const char* str = data.constData();
+    const char* last = str + data.size();
+    while (str < last) {
+        const char* end = (const char*) memchr(str, '\n', last - str);
+        if (!end) {
+            end = last;
+        }
+
+        // reads x, y and z from the line. a coordinate that is missing
+        // is 0, parseFloat() would skip over the end of the line to find it
+        float coordinates[3];
+        for (int i = 0; i < 3; i++) {
+            char* next;
+            coordinates[i] = parseFloat(str, &next);
+            if (next == str || next > end) {
+                coordinates[i] = 0;
+                str = end;
+            } else {
+                str = next;
+            }
+        }
+        Vector3 v = { coordinates[0], coordinates[1], coordinates[2] };
+
+        // adds the object to the vector of vertices
+        points.push_back(v);
+        str = end + 1;
+    }
+    return true;
+}
+
+void pointBounds(const std::vector<Vector3>& points, Vector3& min, Vector3& max) {
+    // the origin is always part of the box
+    min.x = min.y = min.z = 0;
+    max.x = max.y = max.z = 0;
+    for (std::vector<Vector3>::const_iterator it = points.begin(); it != points.end(); ++it) {
+        max.x = std::max(max.x, it->x);
+        max.y = std::max(max.y, it->y);
+        max.z = std::max(max.z, it->z);
+        min.x = std::min(min.x, it->x);
+        min.y = std::min(min.y, it->y);
+        min.z = std::min(min.z, it->z);
+    }
+}
+
+void normalizePoints(std::vector<Vector3>& points, int xCubes, int yCubes, int zCubes) {
+    // maximum and minimum from the data set
+    Vector3 min, max;
+    pointBounds(points, min, max);
+    normalizePoints(points, min, max, xCubes, yCubes, zCubes);
+}
+
+void normalizePoints(std::vector<Vector3>& points, const Vector3& min, const Vector3& max,
+                     int xCubes, int yCubes, int zCubes) {
+    float xMax = max.x;
+    float yMax = max.y;
+    float zMax = max.z;
+    float xMin = min.x;
+    float yMin = min.y;
+    float zMin = min.z;
+
+    // maximum and minimum from the normalized set
+    float xnormmax = xCubes;
+    float xnormmin = 1;
+    float ynormmax = yCubes;
+    float ynormmin = 1;
+    float znormmax = zCubes;
+    float znormmin = 1;
+
+    // iterate the vertices vector and normalize the data
+    for (std::vector<Vector3>::iterator it = points.begin();
+                            it != points.end(); ++it) {
+        it->x =  floor( xnormmin + ((it->x - xMin) 
+                * (xnormmax - xnormmin))/(xMax - xMin) );
+        it->y =  floor( ynormmin + ((it->y - yMin) 
+                * (ynormmax - ynormmin))/(yMax - yMin) );
+        it->z =  floor( znormmin + ((it->z - zMin) 
+                * (znormmax - znormmin))/(zMax - zMin) );
+    }
+}
@@ -0,0 +1,48 @@
+/*  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
+
+ > Animations shown on the cube, as functions of the LED position and
+ > the time, and loading of the point clouds some of them draw.
+
+ > Copyright (C) 2014 by Daniel Intskirveli, Gurpreet Singh, Christopher Zhang.
+
+ > animations.h - what is on and what is off.
+
+ > Written by: Daniel Intskirveli, Gurpreet Singh, Christopher Zhang, 2014.
+
+  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_ */
+
+#ifndef ANIMATIONS_H
+#define ANIMATIONS_H
+
+#include <QString>
+#include <vector>
+#include "frustum.h"
+
+// sine wave moving along z, t is in milliseconds. the LED at
+// height waveHeight() of every x, z column is on
+int waveHeight(int x, int z, int t, int yCubes);
+bool waveIsOn(int x, int y, int z, int t, int xCubes, int yCubes, int zCubes);
+
+// whether one of the (normalized) points is at x, y, z
+bool pointsAreOn(const std::vector<Vector3>& points, int x, int y, int z);
+
+// strtof() for the plain decimals .xyz and .obj files are made of, such
+// as "-12.375" or "1.5e-3", several times faster. anything else (too
+// many digits, inf, nan, hex, a number not followed by white space)
+// is left to strtof()
+float parseFloat(const char* str, char** end);
+
+// appends the points of a .xyz file (one "x y z" per line)
+bool loadXYZ(const QString& file, std::vector<Vector3>& points);
+
+// smallest and largest x, y and z of the points, the origin included
+void pointBounds(const std::vector<Vector3>& points, Vector3& min, Vector3& max);
+
+// scales the points to LED coordinates, 1 to xCubes etc.
+void normalizePoints(std::vector<Vector3>& points, int xCubes, int yCubes, int zCubes);
+
+// the same, but from a given box so that the frames of a sequence keep their scale
+void normalizePoints(std::vector<Vector3>& points, const Vector3& min, const Vector3& max,
+                     int xCubes, int yCubes, int zCubes);
+
+#endif
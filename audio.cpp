@@ -0,0 +1,524 @@
+/*  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
+
+ > AudioLayer class, a spectrum analyzer of a WAV file or a stream of
+ > PCM samples on stdin, shown as bars that scroll back through the cube.
+
+ > Copyright (C) 2014 by Daniel Intskirveli, Gurpreet Singh, Christopher Zhang.
+
+ > audio.cpp - music visualization.
+
+ > Written by: Daniel Intskirveli, Gurpreet Singh, Christopher Zhang, 2014.
+
+  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_ */
+
+#include "audio.h"
+#include <QThread>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QFile>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+enum {
+    FFT_SIZE = 1024,                                        // samples the spectrum is worked out from
+    HOP_SIZE = 256,                                         // samples from one spectrum to the next
+    MAX_BANDS = 256
+};
+
+static const double PI = 3.14159265358979323846;
+static const float MIN_FREQUENCY = 40;                      // of the lowest band, in Hz
+static const float MAX_FREQUENCY = 16000;                   // of the highest band, unless the sample rate is lower
+static const float DB_RANGE = 60;                           // the bars go from -60 dB to full scale
+static const float FALL_SPEED = 1.5f;                       // of the bars, in heights of the cube per second
+
+//! FFT of real samples, as a complex FFT of half the size
+/*!
+    The even samples are the real parts and the odd ones the imaginary
+    parts of the complex FFT, the spectrum of the real samples is then
+    put together from the spectra of both halves.
+*/
+class RealFft
+{
+public:
+    RealFft(int size) : n(size), m(size/2), reversed(size/2), cosines(size/2 + 1),
+                        sines(size/2 + 1), re(size/2), im(size/2) {
+        int bits = 0;
+        while ((1 << bits) < m) {
+            bits++;
+        }
+        for (int i = 0; i < m; i++) {
+            int r = 0;
+            for (int b = 0; b < bits; b++) {
+                r |= ((i >> b) & 1) << (bits - 1 - b);
+            }
+            reversed[i] = r;
+        }
+        for (int k = 0; k <= m; k++) {
+            cosines[k] = (float) cos(2*PI*k/n);
+            sines[k] = (float) sin(2*PI*k/n);
+        }
+    }
+
+    // the power of the bins 0 to size/2 of size samples
+    void power(const float* input, float* output) {
+        for (int i = 0; i < m; i++) {
+            re[reversed[i]] = input[2*i];
+            im[reversed[i]] = input[2*i + 1];
+        }
+
+        // radix 2, the twiddles of a butterfly of len are every n/len-th of the table
+        for (int len = 2; len <= m; len <<= 1) {
+            int half = len/2, step = n/len;
+            for (int start = 0; start < m; start += len) {
+                for (int k = 0; k < half; k++) {
+                    float wr = cosines[k*step], wi = -sines[k*step];
+                    int a = start + k, b = a + half;
+                    float tr = re[b]*wr - im[b]*wi;
+                    float ti = re[b]*wi + im[b]*wr;
+                    re[b] = re[a] - tr;
+                    im[b] = im[a] - ti;
+                    re[a] += tr;
+                    im[a] += ti;
+                }
+            }
+        }
+
+        // bin k is even(k) + e^(-2 pi i k/n) odd(k), where even and odd
+        // are (Z[k] + Z*[m-k])/2 and (Z[k] - Z*[m-k])/2i
+        for (int k = 0; k <= m; k++) {
+            int a = k % m, b = (m - k) % m;
+            float er = (re[a] + re[b])/2, ei = (im[a] - im[b])/2;
+            float orr = (im[a] + im[b])/2, oi = -(re[a] - re[b])/2;
+            float c = cosines[k], s = sines[k];
+            float xr = er + c*orr + s*oi;
+            float xi = ei + c*oi - s*orr;
+            output[k] = xr*xr + xi*xi;
+        }
+    }
+
+private:
+    int n;
+    int m;
+    std::vector<int> reversed;                              // bit reversed order of the m complex samples
+    std::vector<float> cosines, sines;                      // of 2 pi k/n
+    std::vector<float> re, im;
+};
+
+//! The band levels of one spectrum
+struct Spectrum {
+    float bands[MAX_BANDS];                                 // 0 to 1
+    int count;
+    qint64 time;                                            // clock of the analyzer when its newest samples came in, in ns
+};
+
+//! Hands spectra from one thread to another without either one waiting
+/*!
+    Of the three spectra the writer fills one, the reader reads one, and
+    the third one is the newest one that is done. Handing one over swaps
+    it with the middle one in a single atomic exchange. Bit 2 of middle
+    says whether the reader has seen it yet, so the reader always gets
+    the newest spectrum and never one that is still being written.
+*/
+class SpectrumBuffer
+{
+public:
+    SpectrumBuffer() : middle(1), front(0), back(2) {}
+
+    Spectrum& write() { return spectra[back]; }
+    void publish() { back = middle.fetchAndStoreOrdered(back | FRESH) & INDEX; }
+
+    // the newest spectrum, or 0 if there is none since the last call
+    const Spectrum* read() {
+        if (!(middle & FRESH)) {
+            return 0;
+        }
+        front = middle.fetchAndStoreOrdered(front) & INDEX;
+        return &spectra[front];
+    }
+
+private:
+    enum { INDEX = 3, FRESH = 4 };
+
+    Spectrum spectra[3];
+    QAtomicInt middle;
+    int front;                                              // only used by the reader
+    int back;                                               // only used by the writer
+};
+
+static inline int readLE16(const unsigned char* p) {
+    return p[0] | (p[1] << 8);
+}
+
+static inline unsigned int readLE32(const unsigned char* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int) p[3] << 24);
+}
+
+//! Reads the audio as it plays and publishes its spectrum
+class AudioAnalyzer : public QThread
+{
+public:
+    AudioAnalyzer(const QString& source)
+        : source(source), seekable(false), dataStart(0), dataLeft(-1), dataSize(-1), channels(1), rate(44100),
+          bits(16), isFloat(false), stopping(0), bandCount(1), computedBands(0) {
+        clock.start();
+    }
+
+    bool openSource() {
+        if (source == "-") {
+            seekable = false;
+            return file.open(stdin, QIODevice::ReadOnly);
+        }
+        file.setFileName(source);
+        seekable = true;
+        return file.open(QIODevice::ReadOnly);
+    }
+
+    void stop() { stopping = 1; }
+    bool isStdin() const { return !seekable; }
+    void setBands(int count) { bandCount = std::max(1, std::min(count, (int) MAX_BANDS)); }
+    qint64 now() const { return clock.nsecsElapsed(); }
+
+    SpectrumBuffer buffer;
+
+protected:
+    void run() {
+        if (!readHeader()) {
+            std::cerr << "unsupported audio " << source.toLocal8Bit().constData() << std::endl;
+            return;
+        }
+
+        RealFft fft(FFT_SIZE);
+        std::vector<float> window(FFT_SIZE), samples(FFT_SIZE, 0.0f), input(FFT_SIZE), power(FFT_SIZE/2 + 1);
+        std::vector<float> hop(HOP_SIZE);
+        for (int i = 0; i < FFT_SIZE; i++) {
+            window[i] = (float) (0.5 - 0.5*cos(2*PI*i/(FFT_SIZE - 1)));
+        }
+
+        // the spectrum comes out at the speed the audio would play at
+        qint64 start = clock.nsecsElapsed();
+        qint64 played = 0;
+        bool rewound = false;
+        while (!stopping) {
+            int count = readFrames(&hop[0], HOP_SIZE);
+            if (count == 0) {
+                // files play in a loop, a file without samples doesn't
+                if (seekable && !rewound && rewind()) {
+                    rewound = true;
+                    continue;
+                }
+                break;
+            }
+            rewound = false;
+            std::fill(hop.begin() + count, hop.end(), 0.0f);
+            std::copy(samples.begin() + HOP_SIZE, samples.end(), samples.begin());
+            std::copy(hop.begin(), hop.end(), samples.end() - HOP_SIZE);
+            played += count;
+
+            qint64 due = start + played*1000000000LL/rate;
+            qint64 wait = due - clock.nsecsElapsed();
+            if (wait > 0) {
+                usleep((unsigned long) (wait / 1000));
+            }
+            qint64 time = clock.nsecsElapsed();
+
+            for (int i = 0; i < FFT_SIZE; i++) {
+                input[i] = samples[i]*window[i];
+            }
+            fft.power(&input[0], &power[0]);
+            publish(power, time);
+        }
+
+        // the bars fall back down when the stream ends
+        std::fill(power.begin(), power.end(), 0.0f);
+        publish(power, clock.nsecsElapsed());
+    }
+
+private:
+    // the level of every band out of the power of the FFT bins
+    void publish(const std::vector<float>& power, qint64 time) {
+        int count = bandCount;
+        if (count != computedBands) {
+            // bins where the bands start, bands that are narrower than a bin share one
+            float binWidth = (float) rate / FFT_SIZE;
+            float top = std::min(MAX_FREQUENCY, rate/2.0f);
+            bandStart.resize(count + 1);
+            for (int b = 0; b <= count; b++) {
+                double frequency = MIN_FREQUENCY*pow(top/MIN_FREQUENCY, (double) b/count);
+                bandStart[b] = std::max(1, std::min(FFT_SIZE/2, (int) floor(frequency/binWidth + 0.5)));
+            }
+            computedBands = count;
+        }
+
+        // a full scale sine has a peak of (FFT_SIZE/4)^2 with the Hann window
+        float scale = 1.0f / ((FFT_SIZE/4.0f)*(FFT_SIZE/4.0f));
+        Spectrum& spectrum = buffer.write();
+        for (int b = 0; b < count; b++) {
+            int first = bandStart[b];
+            int last = std::max(first + 1, bandStart[b + 1]);
+            float sum = 0;
+            for (int k = first; k < last && k <= FFT_SIZE/2; k++) {
+                sum += power[k];
+            }
+            float mean = sum/(last - first)*scale;
+            float db = mean > 0 ? 10*log10(mean) : -DB_RANGE;
+            spectrum.bands[b] = std::max(0.0f, std::min(1.0f, (db + DB_RANGE)/DB_RANGE));
+        }
+        spectrum.count = count;
+        spectrum.time = time;
+        buffer.publish();
+    }
+
+    int readBytes(char* data, int count) {
+        int got = std::min(count, pending.size());
+        memcpy(data, pending.constData(), got);
+        pending.remove(0, got);
+        while (got < count) {
+            qint64 n = file.read(data + got, count - got);
+            if (n <= 0) {
+                break;
+            }
+            got += (int) n;
+        }
+        return got;
+    }
+
+    bool skipBytes(unsigned int count) {
+        char scratch[4096];
+        while (count > 0) {
+            int n = (int) std::min(count, (unsigned int) sizeof(scratch));
+            if (readBytes(scratch, n) < n) {
+                return false;
+            }
+            count -= n;
+        }
+        return true;
+    }
+
+    // a WAV header, or no header at all
+    bool readHeader() {
+        unsigned char riff[12];
+        int n = readBytes((char*) riff, 12);
+        if (n < 12 || memcmp(riff, "RIFF", 4) != 0 || memcmp(riff + 8, "WAVE", 4) != 0) {
+            // raw samples, they were just read
+            pending = QByteArray((const char*) riff, n);
+            return true;
+        }
+
+        bool haveFormat = false;
+        forever {
+            unsigned char chunk[8];
+            if (readBytes((char*) chunk, 8) < 8) {
+                return false;
+            }
+            unsigned int size = readLE32(chunk + 4);
+            if (memcmp(chunk, "fmt ", 4) == 0) {
+                if (size < 16 || size > 1024) {
+                    return false;
+                }
+                unsigned char format[1024];
+                if (readBytes((char*) format, size) < (int) size || ((size & 1) && !skipBytes(1))) {
+                    return false;
+                }
+                int tag = readLE16(format);
+                if (tag == 0xFFFE && size >= 26) {
+                    tag = readLE16(format + 24);            // WAVE_FORMAT_EXTENSIBLE, the sub format
+                }
+                channels = readLE16(format + 2);
+                rate = (int) readLE32(format + 4);
+                bits = readLE16(format + 14);
+                isFloat = tag == 3;
+                if ((tag != 1 && tag != 3) || channels < 1 || rate <= 0
+                        || (isFloat ? bits != 32 : (bits != 8 && bits != 16 && bits != 24 && bits != 32))) {
+                    return false;
+                }
+                haveFormat = true;
+            } else if (memcmp(chunk, "data", 4) == 0) {
+                // streams that don't know their length write 0 or ~0
+                dataLeft = (size == 0 || size == 0xFFFFFFFFu) ? -1 : size;
+                dataSize = dataLeft;
+                dataStart = seekable ? file.pos() : 0;
+                return haveFormat;
+            } else if (!skipBytes(size + (size & 1))) {
+                return false;
+            }
+        }
+    }
+
+    bool rewind() {
+        pending.clear();
+        dataLeft = dataSize;
+        return file.seek(dataStart);
+    }
+
+    // up to count samples, the channels mixed down to mono
+    int readFrames(float* out, int count) {
+        int sampleBytes = bits/8;
+        int frameBytes = channels*sampleBytes;
+        qint64 want = (qint64) count*frameBytes;
+        if (dataLeft >= 0) {
+            want = std::min(want, dataLeft);
+        }
+        raw.resize((size_t) (count*frameBytes));
+        int got = readBytes(raw.empty() ? 0 : &raw[0], (int) want) / frameBytes;
+        if (dataLeft >= 0) {
+            dataLeft -= (qint64) got*frameBytes;
+        }
+
+        for (int i = 0; i < got; i++) {
+            const unsigned char* frame = (const unsigned char*) &raw[i*frameBytes];
+            float sum = 0;
+            for (int c = 0; c < channels; c++) {
+                const unsigned char* p = frame + c*sampleBytes;
+                switch (bits) {
+                case 8:
+                    sum += (p[0] - 128) / 128.0f;
+                    break;
+                case 16:
+                    sum += (short) readLE16(p) / 32768.0f;
+                    break;
+                case 24:
+                    sum += ((int) ((p[0] << 8) | (p[1] << 16) | ((unsigned int) p[2] << 24)) >> 8) / 8388608.0f;
+                    break;
+                default:
+                    if (isFloat) {
+                        unsigned int u = readLE32(p);
+                        float f;
+                        memcpy(&f, &u, sizeof(f));
+                        sum += f;
+                    } else {
+                        sum += (int) readLE32(p) / 2147483648.0f;
+                    }
+                    break;
+                }
+            }
+            out[i] = sum/channels;
+        }
+        return got;
+    }
+
+    QString source;
+    QFile file;
+    QByteArray pending;                                     // read while looking for a header that wasn't there
+    std::vector<char> raw;                                  // the bytes of the last readFrames()
+    bool seekable;                                          // a file, not stdin
+    qint64 dataStart;
+    qint64 dataLeft;                                        // bytes of samples left, -1 for up to the end
+    qint64 dataSize;
+    int channels;
+    int rate;
+    int bits;
+    bool isFloat;
+    QAtomicInt stopping;
+    QAtomicInt bandCount;                                   // set by the layer, one band per LED along x
+    int computedBands;
+    std::vector<int> bandStart;
+    QElapsedTimer clock;
+};
+
+// ---------------------------------------------------------------------
+
+AudioLayer::AudioLayer()
+    : analyzer(0), w(0), h(0), d(0), newest(0), last(-1), latencyFrames(0), latencySum(0), latencyMax(0) {
+}
+
+AudioLayer::~AudioLayer() {
+    close();
+}
+
+bool AudioLayer::open(const QString& source) {
+    close();
+    AudioAnalyzer* opened = new AudioAnalyzer(source);
+    if (!opened->openSource()) {
+        delete opened;
+        return false;
+    }
+    analyzer = opened;
+    analyzer->setBands(w);
+    analyzer->start();
+    std::fill(history.begin(), history.end(), 0.0f);
+    std::fill(current.begin(), current.end(), 0.0f);
+    return true;
+}
+
+void AudioLayer::close() {
+    if (!analyzer) {
+        return;
+    }
+    analyzer->stop();
+    // a read of stdin that nothing is coming in on doesn't return
+    if (!analyzer->wait(1000) && analyzer->isStdin()) {
+        analyzer->terminate();
+        analyzer->wait();
+    }
+    delete analyzer;
+    analyzer = 0;
+}
+
+void AudioLayer::resize(int width, int height, int depth) {
+    w = width;
+    h = height;
+    d = depth;
+    history.assign((size_t) w*d, 0.0f);
+    current.assign(w, 0.0f);
+    newest = 0;
+    if (analyzer) {
+        analyzer->setBands(w);
+    }
+}
+
+int AudioLayer::takeLatency(double& mean, double& max) {
+    int frames = latencyFrames;
+    mean = frames ? latencySum/frames : 0;
+    max = latencyMax;
+    latencyFrames = 0;
+    latencySum = 0;
+    latencyMax = 0;
+    return frames;
+}
+
+void AudioLayer::render(BitPlane& plane, int t) {
+    if (w == 0 || h == 0 || d == 0) {
+        return;
+    }
+
+    // the history moves on once per frame. the other cubes of a wall,
+    // which come with a t up to a few wall phases older, show it as it is
+    bool restart = last < 0 || t < last - RESTART_MS;
+    if (restart || t > last) {
+        float dt = restart ? 0 : (t - last) / 1000.0f;
+        last = t;
+
+        const Spectrum* spectrum = analyzer ? analyzer->buffer.read() : 0;
+        if (spectrum) {
+            double latency = (analyzer->now() - spectrum->time) / 1000000.0;
+            latencyFrames++;
+            latencySum += latency;
+            latencyMax = std::max(latencyMax, latency);
+            for (int x = 0; x < w; x++) {
+                current[x] = spectrum->bands[(long long) x*spectrum->count/w];
+            }
+        }
+
+        // everything moves one step back, the bars in front jump up
+        // to the spectrum and fall down slowly
+        const float* previous = &history[newest*w];
+        newest = (newest + d - 1) % d;
+        float* row = &history[newest*w];
+        for (int x = 0; x < w; x++) {
+            row[x] = std::max(current[x], previous[x] - FALL_SPEED*dt);
+        }
+    }
+
+    for (int z = 0; z < d; z++) {
+        const float* levels = &history[((newest + z) % d)*w];
+        for (int x = 0; x < w; x++) {
+            int height = std::min(h, (int) (levels[x]*h + 0.5f));
+            for (int y = 0; y < height; y++) {
+                plane.set(x, y, z);
+            }
+        }
+    }
+}
@@ -0,0 +1,73 @@
+/*  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
+
+ > AudioLayer class, a spectrum analyzer of a WAV file or a stream of
+ > PCM samples on stdin, shown as bars that scroll back through the cube.
+
+ > Copyright (C) 2014 by Daniel Intskirveli, Gurpreet Singh, Christopher Zhang.
+
+ > audio.h - music visualization.
+
+ > Written by: Daniel Intskirveli, Gurpreet Singh, Christopher Zhang, 2014.
+
+  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_ */
+
+#ifndef AUDIO_H
+#define AUDIO_H
+
+#include <QString>
+#include <vector>
+#include "compositor.h"
+
+class AudioAnalyzer;
+
+//! The spectrum of the audio that is playing
+/*!
+    A thread reads the audio as fast as it would play, 256 samples at a
+    time, and works out the spectrum of the last 1024 with an FFT each
+    time. The energy of bands that are evenly spaced on a log scale
+    from 40 Hz up, one per LED along x, is handed over through a triple
+    buffer: neither side ever waits for the other, render() just picks up
+    the newest spectrum there is.
+
+    The bars go up along y, like the wave. Every frame the spectrum on
+    display moves one step back along z, so z is the history.
+
+    The latency is the age of the newest samples in a spectrum when a
+    frame picks it up, the analysis and the wait for the frame. The FFT
+    window adds about half its length (12 ms at 44.1 kHz) on top.
+*/
+class AudioLayer : public Layer
+{
+public:
+    AudioLayer();
+    ~AudioLayer();
+
+    std::string name() const { return "Audio Spectrum"; }
+    bool isAnimated() const { return true; }
+    void resize(int width, int height, int depth);
+    void render(BitPlane& plane, int t);
+
+    // a .wav file, which is played in a loop, or "-" for stdin. stdin
+    // can be a WAV stream too, anything else is taken as 16 bit signed
+    // little endian mono samples at 44.1 kHz. false if it can't be opened
+    bool open(const QString& source);
+    bool isOpen() const { return analyzer != 0; }
+    void close();
+
+    // milliseconds from the audio to the frames showing it since the last
+    // call, returns the number of frames that had a new spectrum
+    int takeLatency(double& mean, double& max);
+
+private:
+    AudioAnalyzer* analyzer;
+    int w, h, d;
+    std::vector<float> history;                             // levels 0 to 1, a ring of d rows of w bands
+    int newest;                                             // the row shown at z = 0
+    std::vector<float> current;                             // the newest spectrum, one level per x
+    int last;                                               // t of the newest frame, -1 before the first
+    int latencyFrames;
+    double latencySum;
+    double latencyMax;
+};
+
+#endif
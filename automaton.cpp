@@ -0,0 +1,533 @@
+/*  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
+
+ > Automaton class, a 3D cellular automaton such as 3D Life on a packed
+ > grid of bits, and the layer that shows it on the cube.
+
+ > Copyright (C) 2014 by Daniel Intskirveli, Gurpreet Singh, Christopher Zhang.
+
+ > automaton.cpp - birth / survive cellular automata.
+
+ > Written by: Daniel Intskirveli, Gurpreet Singh, Christopher Zhang, 2014.
+
+  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_ */
+
+#include "automaton.h"
+#include <QThread>
+#include <QAtomicInt>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+
+typedef Automaton::Word Word;
+
+enum { MAX_NEIGHBOURS = 26 };
+
+// adds the numbers of a rule part, "4-5,7" or "457", to mask
+static bool parseCounts(const std::string& counts, unsigned int& mask) {
+    if (counts.find_first_of(",-") == std::string::npos) {
+        for (size_t i = 0; i < counts.size(); i++) {
+            if (!isdigit((unsigned char) counts[i])) {
+                return false;
+            }
+            mask |= 1u << (counts[i] - '0');
+        }
+        return true;
+    }
+    const char* p = counts.c_str();
+    while (*p) {
+        char* end;
+        long first = strtol(p, &end, 10);
+        long last = first;
+        if (end == p) {
+            return false;
+        }
+        if (*end == '-') {
+            p = end + 1;
+            last = strtol(p, &end, 10);
+            if (end == p) {
+                return false;
+            }
+        }
+        if (first < 0 || last > MAX_NEIGHBOURS || first > last) {
+            return false;
+        }
+        for (long n = first; n <= last; n++) {
+            mask |= 1u << n;
+        }
+        p = end;
+        if (*p == ',') {
+            p++;
+        } else if (*p) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool parseRule(const std::string& rule, unsigned int& birth, unsigned int& survive) {
+    unsigned int b = 0, s = 0;
+    bool haveBirth = false, haveSurvive = false;
+    size_t start = 0;
+    while (start <= rule.size()) {
+        size_t slash = rule.find('/', start);
+        if (slash == std::string::npos) {
+            slash = rule.size();
+        }
+        std::string part = rule.substr(start, slash - start);
+        start = slash + 1;
+
+        char kind = part.empty() ? 0 : (char) toupper((unsigned char) part[0]);
+        if (kind == 'B' && !haveBirth) {
+            haveBirth = parseCounts(part.substr(1), b);
+            if (!haveBirth) {
+                return false;
+            }
+        } else if (kind == 'S' && !haveSurvive) {
+            haveSurvive = parseCounts(part.substr(1), s);
+            if (!haveSurvive) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+    if (!haveBirth || !haveSurvive) {
+        return false;
+    }
+    birth = b;
+    survive = s;
+    return true;
+}
+
+// ---------------------------------------------------------------------
+
+//! One step of an Automaton, shared by the threads that work on it
+struct AutomatonJob {
+    const Word* cells;
+    Word* next;
+    int w, h, d, n;                                         // n words per row
+    Word lastMask;
+    bool wrap;
+    const Automaton::RuleNode* rule;
+    int ruleCount;
+    int root;
+    int slabSize;
+    int slabs;
+    QAtomicInt nextSlab;
+    QAtomicInt changed;                                     // 1 once a thread saw a cell change
+};
+
+//! What a thread needs to step a slab, allocated once per step
+struct AutomatonScratch {
+    AutomatonScratch(const AutomatonJob& job)
+        : zero(job.n, 0), rows(2*job.h*job.n), planes(3*4*job.h*job.n), values(job.ruleCount + 2) {}
+
+    std::vector<Word> zero;                                 // a row of dead cells outside the grid
+    std::vector<Word> rows;                                 // bits 0 and 1 of the row sums of one plane
+    std::vector<Word> planes;                               // bits 0 to 3 of the plane sums, for x-1, x and x+1
+    std::vector<Word> values;                               // rule nodes, see evaluate()
+};
+
+// the neighbour at i + offset along an axis of size, -1 outside of it
+static inline int neighbour(int i, int offset, int size, bool wrap) {
+    i += offset;
+    if (i < 0 || i >= size) {
+        return wrap ? (i + size) % size : -1;
+    }
+    return i;
+}
+
+// each cell plus its z neighbours, 0 to 3 in two bits
+static void sumRow(const AutomatonJob& job, const Word* row, Word* s0, Word* s1) {
+    int n = job.n;
+    Word first = row[0] & 1;                                // cell 0 and d-1, neighbours when wrapped
+    Word last = (row[n - 1] >> ((job.d - 1) & 63)) & 1;
+    for (int k = 0; k < n; k++) {
+        Word c = row[k];
+        Word l = c << 1;                                    // the cell at z-1 moved to z
+        Word r = c >> 1;                                    // the cell at z+1 moved to z
+        if (k > 0) {
+            l |= row[k - 1] >> 63;
+        } else if (job.wrap) {
+            l |= last;
+        }
+        if (k < n - 1) {
+            r |= row[k + 1] << 63;
+        } else if (job.wrap) {
+            r |= first << ((job.d - 1) & 63);
+        }
+        Word x = l ^ c;
+        s0[k] = x ^ r;
+        s1[k] = (l & c) | (x & r);
+    }
+}
+
+// the row sums of plane x added up along y, 0 to 9 in four bits
+static void sumPlane(const AutomatonJob& job, AutomatonScratch& scratch, int x, Word* sum) {
+    int n = job.n, h = job.h, size = h*n;
+    if (x < 0) {
+        std::fill(sum, sum + 4*size, 0);
+        return;
+    }
+    Word* r0 = &scratch.rows[0];
+    Word* r1 = r0 + size;
+    for (int y = 0; y < h; y++) {
+        sumRow(job, job.cells + (x*h + y)*n, r0 + y*n, r1 + y*n);
+    }
+
+    const Word* zero = &scratch.zero[0];
+    for (int y = 0; y < h; y++) {
+        int below = neighbour(y, -1, h, job.wrap);
+        int above = neighbour(y, 1, h, job.wrap);
+        const Word* a0 = below < 0 ? zero : r0 + below*n;
+        const Word* a1 = below < 0 ? zero : r1 + below*n;
+        const Word* b0 = r0 + y*n;
+        const Word* b1 = r1 + y*n;
+        const Word* c0 = above < 0 ? zero : r0 + above*n;
+        const Word* c1 = above < 0 ? zero : r1 + above*n;
+        Word* out = sum + y*n;
+        for (int k = 0; k < n; k++) {
+            // bit 0 of the three numbers, carry into bit 1
+            Word x0 = a0[k] ^ b0[k];
+            Word carry = (a0[k] & b0[k]) | (x0 & c0[k]);
+            // bit 1 of the three numbers and the carry, up to 4 twos
+            Word x1 = a1[k] ^ b1[k];
+            Word u = x1 ^ c1[k];
+            Word v = (a1[k] & b1[k]) | (x1 & c1[k]);
+            out[k] = x0 ^ c0[k];
+            out[k + size] = u ^ carry;
+            Word fours = u & carry;
+            out[k + 2*size] = v ^ fours;
+            out[k + 3*size] = v & fours;
+        }
+    }
+}
+
+// the rule of the cell for 64 cells at once, bits[0-4] is the count and bits[5] the cell
+static inline Word evaluate(const AutomatonJob& job, Word* values, const Word* bits) {
+    for (int i = 0; i < job.ruleCount; i++) {
+        const Automaton::RuleNode& node = job.rule[i];
+        Word b = bits[node.bit];
+        values[i + 2] = (b & values[node.hi]) | (~b & values[node.lo]);
+    }
+    return values[job.root];
+}
+
+static void stepSlab(AutomatonJob& job, AutomatonScratch& scratch, int slab) {
+    int n = job.n, h = job.h, size = h*n;
+    int x0 = slab*job.slabSize;
+    int x1 = std::min(job.w, x0 + job.slabSize);
+
+    // the plane sums of x-1, x and x+1, each one is worked out once
+    Word* planes[3] = { &scratch.planes[0], &scratch.planes[4*size], &scratch.planes[8*size] };
+    sumPlane(job, scratch, neighbour(x0, -1, job.w, job.wrap), planes[0]);
+    sumPlane(job, scratch, x0, planes[1]);
+
+    Word* values = &scratch.values[0];
+    values[0] = 0;
+    values[1] = ~(Word) 0;
+    Word changed = 0;
+    for (int x = x0; x < x1; x++) {
+        sumPlane(job, scratch, neighbour(x, 1, job.w, job.wrap), planes[2]);
+        const Word* a = planes[0];
+        const Word* b = planes[1];
+        const Word* c = planes[2];
+        for (int y = 0; y < h; y++) {
+            for (int k = 0; k < n; k++) {
+                int i = y*n + k;
+                // the three numbers bit by bit, then the carries rippled through
+                Word s[4], carry[4];
+                for (int bit = 0; bit < 4; bit++) {
+                    Word p = a[i + bit*size], q = b[i + bit*size], r = c[i + bit*size];
+                    Word x = p ^ q;
+                    s[bit] = x ^ r;
+                    carry[bit] = (p & q) | (x & r);
+                }
+                Word bits[6];
+                bits[0] = s[0];
+                bits[1] = s[1] ^ carry[0];
+                Word ripple = s[1] & carry[0];
+                Word x2 = s[2] ^ carry[1];
+                bits[2] = x2 ^ ripple;
+                ripple = (s[2] & carry[1]) | (x2 & ripple);
+                Word x3 = s[3] ^ carry[2];
+                bits[3] = x3 ^ ripple;
+                ripple = (s[3] & carry[2]) | (x3 & ripple);
+                bits[4] = carry[3] ^ ripple;                // at most 27, never a sixth bit
+
+                int row = (x*h + y)*n;
+                bits[5] = job.cells[row + k];
+                Word cell = evaluate(job, values, bits);
+                if (k == n - 1) {
+                    cell &= job.lastMask;
+                }
+                job.next[row + k] = cell;
+                changed |= cell ^ bits[5];
+            }
+        }
+        std::swap(planes[0], planes[1]);
+        std::swap(planes[1], planes[2]);
+    }
+    if (changed) {
+        job.changed = 1;
+    }
+}
+
+//! Steps slabs until there are none left
+class AutomatonThread : public QThread
+{
+public:
+    AutomatonThread(AutomatonJob* job) : job(job) {}
+
+    static void work(AutomatonJob* job) {
+        AutomatonScratch scratch(*job);
+        int slab;
+        while ((slab = job->nextSlab.fetchAndAddOrdered(1)) < job->slabs) {
+            stepSlab(*job, scratch, slab);
+        }
+    }
+
+protected:
+    void run() {
+        work(job);
+    }
+
+private:
+    AutomatonJob* job;
+};
+
+// ---------------------------------------------------------------------
+
+Automaton::Automaton()
+    : w(0), h(0), d(0), rowWords(0), lastMask(0), wrap(true), generations(0) {
+    // Bays' 3D Life 5766, B6/S5-7
+    setRule(1u << 6, (1u << 5) | (1u << 6) | (1u << 7));
+}
+
+void Automaton::resize(int width, int height, int depth) {
+    w = width;
+    h = height;
+    d = depth;
+    rowWords = (d + 63) / 64;
+    lastMask = (d & 63) ? ((Word) 1 << (d & 63)) - 1 : ~(Word) 0;
+    cells.assign((size_t) w*h*rowWords, 0);
+    next.assign(cells.size(), 0);
+    generations = 0;
+}
+
+void Automaton::setRule(unsigned int birthMask, unsigned int surviveMask) {
+    birth = birthMask & ((1u << (MAX_NEIGHBOURS + 1)) - 1);
+    survive = surviveMask & ((1u << (MAX_NEIGHBOURS + 1)) - 1);
+    compileRule();
+}
+
+void Automaton::setWrap(bool wrapped) {
+    wrap = wrapped;
+}
+
+void Automaton::compileRule() {
+    // step() counts the cell itself too, so the table is indexed by
+    // cell*32 + count, where a live cell's count is one too many
+    unsigned long long table = (unsigned long long) birth | ((unsigned long long) survive << 33);
+    rule.clear();
+    root = compileRule(6, table);
+}
+
+int Automaton::compileRule(int level, unsigned long long table) {
+    // the lower half of the table is the function for bit level-1 off,
+    // the upper half for it on. halves that are the same need no test,
+    // and nodes that are the same are shared
+    int size = 1 << level;
+    unsigned long long all = size == 64 ? ~0ULL : (1ULL << size) - 1;
+    table &= all;
+    if (table == 0) {
+        return 0;
+    }
+    if (table == all) {
+        return 1;
+    }
+    RuleNode node;
+    node.bit = level - 1;
+    node.lo = compileRule(level - 1, table);
+    node.hi = compileRule(level - 1, table >> (size / 2));
+    if (node.lo == node.hi) {
+        return node.lo;
+    }
+    for (size_t i = 0; i < rule.size(); i++) {
+        if (rule[i].bit == node.bit && rule[i].lo == node.lo && rule[i].hi == node.hi) {
+            return (int) i + 2;
+        }
+    }
+    rule.push_back(node);
+    return (int) rule.size() + 1;
+}
+
+void Automaton::clear() {
+    std::fill(cells.begin(), cells.end(), 0);
+    generations = 0;
+}
+
+void Automaton::randomize(double density, unsigned int seed) {
+    // a bit of an AND of random words is on with a chance of 1/2, of an
+    // OR 3/4. going through the bits of the density from the lowest,
+    // AND for a 0 and OR for a 1, gives every bit a chance of density
+    int p = (int) floor(std::max(0.0, std::min(1.0, density))*256 + 0.5);
+    Word state = seed*0x9E3779B97F4A7C15ULL + 1;
+    for (size_t i = 0; i < cells.size(); i++) {
+        Word bits = p == 256 ? ~(Word) 0 : 0;
+        for (int b = 0; b < 8 && p < 256; b++) {
+            // xorshift64*
+            state ^= state >> 12;
+            state ^= state << 25;
+            state ^= state >> 27;
+            Word random = state*0x2545F4914F6CDD1DULL;
+            bits = (p >> b) & 1 ? bits | random : bits & random;
+        }
+        if ((int) (i % rowWords) == rowWords - 1) {
+            bits &= lastMask;
+        }
+        cells[i] = bits;
+    }
+    generations = 0;
+}
+
+void Automaton::set(int x, int y, int z, bool alive) {
+    Word& word = cells[(x*h + y)*rowWords + (z >> 6)];
+    Word bit = (Word) 1 << (z & 63);
+    word = alive ? word | bit : word & ~bit;
+}
+
+bool Automaton::step() {
+    if (cells.empty()) {
+        return false;
+    }
+
+    // slabs of a few planes, about 4 for every thread. a small
+    // grid isn't worth starting threads for
+    int threads = w*h*d < 64*64*64 ? 1 : std::max(1, QThread::idealThreadCount());
+    AutomatonJob job;
+    job.cells = &cells[0];
+    job.next = &next[0];
+    job.w = w;
+    job.h = h;
+    job.d = d;
+    job.n = rowWords;
+    job.lastMask = lastMask;
+    job.wrap = wrap;
+    job.rule = rule.empty() ? 0 : &rule[0];
+    job.ruleCount = (int) rule.size();
+    job.root = root;
+    job.slabSize = std::max(1, w / (threads*4));
+    job.slabs = (w + job.slabSize - 1) / job.slabSize;
+    job.nextSlab = 0;
+    job.changed = 0;
+
+    std::vector<AutomatonThread*> helpers;
+    for (int i = 1; i < threads && i < job.slabs; i++) {
+        helpers.push_back(new AutomatonThread(&job));
+        helpers.back()->start();
+    }
+    AutomatonThread::work(&job);
+    for (size_t i = 0; i < helpers.size(); i++) {
+        helpers[i]->wait();
+        delete helpers[i];
+    }
+
+    cells.swap(next);
+    generations++;
+    return job.changed != 0;
+}
+
+void Automaton::render(BitPlane& plane) const {
+    // the rows are whole words here, in the plane they follow each other
+    // without a gap, so every word of a row is split over two words
+    BitPlane::Word* out = plane.data();
+    int count = plane.wordCount();
+    for (int row = 0; row < w*h; row++) {
+        const Word* in = &cells[row*rowWords];
+        long long bit = (long long) row*d;
+        for (int k = 0; k < rowWords; k++, bit += 64) {
+            Word word = in[k];
+            if (!word) {
+                continue;
+            }
+            int i = (int) (bit >> 6), shift = (int) (bit & 63);
+            out[i] |= word << shift;
+            if (shift && i + 1 < count) {
+                out[i + 1] |= word >> (64 - shift);
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------------
+
+static const double SEED_DENSITY = 0.3;                    // of the cells alive after seeding
+enum { MAX_CATCH_UP = 4 };                                  // steps per frame at most, the rest are skipped
+
+AutomatonLayer::AutomatonLayer() : speed(10), seeds(0), start(-1) {
+}
+
+void AutomatonLayer::resize(int width, int height, int depth) {
+    automaton.resize(width, height, depth);
+    seed();
+    start = -1;
+}
+
+void AutomatonLayer::seed() {
+    automaton.randomize(SEED_DENSITY, ++seeds);
+}
+
+void AutomatonLayer::render(BitPlane& plane, int t) {
+    if (automaton.width() != plane.width() || automaton.height() != plane.height()
+            || automaton.depth() != plane.depth()) {
+        return;
+    }
+
+    // going back in time (an export starting at 0) starts over. the
+    // cubes of a wall that are a wall phase behind only show the cells
+    if (start >= 0 && t < start - RESTART_MS) {
+        seed();
+        start = -1;
+    }
+    if (start < 0) {
+        start = t - (int) (automaton.generation()*1000/speed);
+    }
+    int target = (int) floor((t - start)*speed/1000);
+    int behind = target - automaton.generation();
+    if (behind > MAX_CATCH_UP) {
+        // too slow to keep up, carry on from here rather than falling further behind
+        start += (int) ((behind - MAX_CATCH_UP)*1000/speed);
+        behind = MAX_CATCH_UP;
+    }
+    for (int i = 0; i < behind; i++) {
+        if (!automaton.step()) {
+            // dead or stuck, start again with another seed
+            seed();
+            start = t;
+            break;
+        }
+    }
+    automaton.render(plane);
+}
+
+bool AutomatonLayer::setRule(const std::string& rule) {
+    unsigned int birth, survive;
+    if (!parseRule(rule, birth, survive)) {
+        return false;
+    }
+    automaton.setRule(birth, survive);
+    seed();
+    start = -1;
+    return true;
+}
+
+void AutomatonLayer::setWrap(bool wrap) {
+    automaton.setWrap(wrap);
+}
+
+void AutomatonLayer::setSpeed(double stepsPerSecond) {
+    speed = std::max(0.1, stepsPerSecond);
+    start = -1;
+}
@@ -0,0 +1,122 @@
+/*  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
+
+ > Automaton class, a 3D cellular automaton such as 3D Life on a packed
+ > grid of bits, and the layer that shows it on the cube.
+
+ > Copyright (C) 2014 by Daniel Intskirveli, Gurpreet Singh, Christopher Zhang.
+
+ > automaton.h - birth / survive cellular automata.
+
+ > Written by: Daniel Intskirveli, Gurpreet Singh, Christopher Zhang, 2014.
+
+  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_ */
+
+#ifndef AUTOMATON_H
+#define AUTOMATON_H
+
+#include <string>
+#include <vector>
+#include "compositor.h"
+
+// reads a rule such as "B5/S4-5" or "B6,7/S5,6,7,8" into masks with
+// bit n set for n live neighbours. without commas or ranges every
+// digit is a count of its own, so "B36/S23" works too
+bool parseRule(const std::string& rule, unsigned int& birth, unsigned int& survive);
+
+//! Birth / survive cellular automaton on the 26 neighbours of each cell
+/*!
+    Every row along z is padded to whole 64 bit words, so that the z
+    neighbours of 64 cells are a shift away. step() adds up the
+    neighbours of 64 cells at once with bit-sliced adders: each bit of
+    the count has a word of its own. A row is added to its z neighbours
+    (0-3), those to the rows at y-1 and y+1 (0-9), and those to the
+    planes at x-1 and x+1 (0-27, the cell itself included). The rule is
+    then a boolean function of the cell and the 5 bits of the count.
+
+    The grid is double buffered, and the x planes are split into slabs
+    that are stepped by one thread per core.
+*/
+class Automaton
+{
+public:
+    typedef unsigned long long Word;
+
+    Automaton();
+
+    void resize(int width, int height, int depth);
+    int width() const { return w; }
+    int height() const { return h; }
+    int depth() const { return d; }
+
+    // births and survivals for 0 to 26 live neighbours, bit n for n
+    void setRule(unsigned int birth, unsigned int survive);
+
+    // with wrap the grid is a torus, otherwise there are dead cells around it
+    void setWrap(bool wrap);
+    bool isWrapped() const { return wrap; }
+
+    void clear();
+    // about density of all cells alive, in steps of 1/256
+    void randomize(double density, unsigned int seed);
+    bool test(int x, int y, int z) const {
+        return (cells[(x*h + y)*rowWords + (z >> 6)] >> (z & 63)) & 1;
+    }
+    void set(int x, int y, int z, bool alive);
+
+    // advances one generation, returns false when nothing changed
+    bool step();
+    int generation() const { return generations; }
+
+    // turns on the LEDs of the cells that are alive, the plane has the size of the grid
+    void render(BitPlane& plane) const;
+
+    // for step(): the rule as a tree of "bit ? hi : lo", see compileRule()
+    struct RuleNode {
+        int bit;                                            // 0-4 the count, 5 the cell itself
+        int lo, hi;                                         // 0 is never, 1 always, n nodes[n - 2]
+    };
+
+private:
+    void compileRule();
+    int compileRule(int level, unsigned long long table);
+
+    int w;
+    int h;
+    int d;
+    int rowWords;                                           // words per row along z
+    Word lastMask;                                          // the bits of the last word of a row that are cells
+    bool wrap;
+    unsigned int birth;
+    unsigned int survive;
+    std::vector<RuleNode> rule;
+    int root;
+    std::vector<Word> cells;                                // (x*h + y)*rowWords + z/64
+    std::vector<Word> next;
+    int generations;
+};
+
+//! An automaton that steps at a fixed rate, reseeded when it dies out
+class AutomatonLayer : public Layer
+{
+public:
+    AutomatonLayer();
+
+    std::string name() const { return "Cellular Automaton"; }
+    bool isAnimated() const { return true; }
+    void resize(int width, int height, int depth);
+    void render(BitPlane& plane, int t);
+
+    bool setRule(const std::string& rule);                  // false if it doesn't parse
+    void setWrap(bool wrap);
+    void setSpeed(double stepsPerSecond);
+
+private:
+    void seed();
+
+    Automaton automaton;
+    double speed;
+    unsigned int seeds;                                     // seeds used so far, every one looks different
+    int start;                                              // t of generation 0, -1 until the first render()
+};
+
+#endif
@@ -0,0 +1,679 @@
+/*  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
+
+ > Microbenchmarks for the hot paths of the simulation: the animations,
+ > resizing the lattice, loading point clouds and building the points
+ > and cubes that paintGL() draws.
+
+ > Copyright (C) 2014 by Daniel Intskirveli, Gurpreet Singh, Christopher Zhang.
+
+ > bench.cpp - run with --help for the options.
+
+ > Written by: Daniel Intskirveli, Gurpreet Singh, Christopher Zhang, 2014.
+
+  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_ */
+
+#include <QElapsedTimer>
+#include <QTemporaryFile>
+#include <QFile>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "lattice.h"
+#include "animations.h"
+#include "layers.h"
+#include "driver.h"
+#include "mesh.h"
+#include "automaton.h"
+#include "particles.h"
+
+// results are added to this so the compiler can't throw the work away
+static volatile long long sink = 0;
+
+//! Options from the command line
+struct Options {
+    int warmup;                                             // samples that are thrown away
+    int repetitions;                                        // samples that are kept
+    double sampleMs;                                        // aim for samples of about this long
+    long long maxPoints;                                    // largest synthetic point cloud
+    std::string filter;                                     // only run benchmarks with this in their name
+    std::string face;                                       // path of face-male.xyz
+    bool csv;
+
+    Options() : warmup(3), repetitions(20), sampleMs(20), maxPoints(1000000), face("face-male.xyz"), csv(false) {}
+};
+
+//! A single benchmark
+/*!
+    setUp() and tearDown() are not timed. run() does the work
+    iterations times in a row, the time is divided by iterations.
+*/
+class Benchmark
+{
+public:
+    Benchmark(const std::string& name, double itemsPerIteration)
+        : name(name), items(itemsPerIteration) {}
+    virtual ~Benchmark() {}
+
+    virtual bool setUp() { return true; }
+    virtual void run(int iterations) = 0;
+    virtual void tearDown() {}
+
+    std::string name;
+    double items;                                           // voxels, points, ... handled per iteration
+};
+
+// nearest rank percentile of sorted values
+static double percentile(const std::vector<double>& sorted, double p) {
+    int rank = (int) ceil(p / 100 * sorted.size());
+    return sorted[std::max(0, std::min(rank - 1, (int) sorted.size() - 1))];
+}
+
+static double timeRun(Benchmark& benchmark, int iterations) {
+    QElapsedTimer timer;
+    timer.start();
+    benchmark.run(iterations);
+    return (double) timer.nsecsElapsed();
+}
+
+static void printHeader(const Options& options) {
+    if (options.csv) {
+        printf("name,iterations,samples,items_per_op,min_ns,median_ns,p90_ns,p99_ns,mean_ns,stddev_ns,ns_per_item\n");
+    }
+}
+
+static void runBenchmark(Benchmark& benchmark, const Options& options) {
+    if (!options.filter.empty() && benchmark.name.find(options.filter) == std::string::npos) {
+        return;
+    }
+    if (!benchmark.setUp()) {
+        fprintf(stderr, "skipping %s\n", benchmark.name.c_str());
+        return;
+    }
+
+    // pick the number of iterations per sample from one untimed run,
+    // so that short operations are not dominated by the timer
+    double first = timeRun(benchmark, 1);
+    int iterations = (int) std::max(1.0, options.sampleMs * 1e6 / std::max(first, 1.0));
+    int repetitions = options.repetitions;
+    if (first > 1e9) {
+        // a second or more per run, a few samples will have to do
+        repetitions = std::min(repetitions, 5);
+    }
+
+    for (int i = 0; i < options.warmup; i++) {
+        timeRun(benchmark, iterations);
+    }
+    std::vector<double> samples;
+    for (int i = 0; i < repetitions; i++) {
+        samples.push_back(timeRun(benchmark, iterations) / iterations);
+    }
+    benchmark.tearDown();
+
+    std::sort(samples.begin(), samples.end());
+    double mean = 0;
+    for (size_t i = 0; i < samples.size(); i++) {
+        mean += samples[i];
+    }
+    mean /= samples.size();
+    double variance = 0;
+    for (size_t i = 0; i < samples.size(); i++) {
+        variance += (samples[i] - mean) * (samples[i] - mean);
+    }
+    double stddev = sqrt(variance / std::max(1, (int) samples.size() - 1));
+    double median = percentile(samples, 50);
+
+    if (options.csv) {
+        printf("%s,%d,%d,%.0f,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%.3f\n",
+            benchmark.name.c_str(), iterations, (int) samples.size(), benchmark.items,
+            samples.front(), median, percentile(samples, 90), percentile(samples, 99),
+            mean, stddev, median / benchmark.items);
+    } else {
+        printf("{\"name\": \"%s\", \"iterations\": %d, \"samples\": %d, \"items_per_op\": %.0f, "
+               "\"min_ns\": %.1f, \"median_ns\": %.1f, \"p90_ns\": %.1f, \"p99_ns\": %.1f, "
+               "\"mean_ns\": %.1f, \"stddev_ns\": %.1f, \"ns_per_item\": %.3f}\n",
+            benchmark.name.c_str(), iterations, (int) samples.size(), benchmark.items,
+            samples.front(), median, percentile(samples, 90), percentile(samples, 99),
+            mean, stddev, median / benchmark.items);
+    }
+    fflush(stdout);
+}
+
+static std::string sizeName(const char* prefix, long long size) {
+    char name[128];
+    sprintf(name, "%s/%lld", prefix, size);
+    return name;
+}
+
+//! MatrixWidget::isOn() for the wave, over the whole cube
+class WaveIsOn : public Benchmark
+{
+public:
+    WaveIsOn(int size) : Benchmark(sizeName("isOn/wave", size), (double) size*size*size), size(size), t(0) {}
+
+    void run(int iterations) {
+        long long on = 0;
+        for (int n = 0; n < iterations; n++) {
+            t += 33;
+            for (int x = 0; x < size; x++) {
+                for (int y = 0; y < size; y++) {
+                    for (int z = 0; z < size; z++) {
+                        on += waveIsOn(x, y, z, t, size, size, size);
+                    }
+                }
+            }
+        }
+        sink += on;
+    }
+
+private:
+    int size;
+    int t;
+};
+
+//! MatrixWidget::isOn() for the face, over the whole cube
+class FaceIsOn : public Benchmark
+{
+public:
+    FaceIsOn(int size, const std::string& file)
+        : Benchmark(sizeName("isOn/face", size), (double) size*size*size), size(size), file(file) {}
+
+    bool setUp() {
+        points.clear();
+        if (!loadXYZ(QString::fromLocal8Bit(file.c_str()), points)) {
+            return false;
+        }
+        normalizePoints(points, size, size, size);
+        return true;
+    }
+
+    void run(int iterations) {
+        long long on = 0;
+        for (int n = 0; n < iterations; n++) {
+            for (int x = 0; x < size; x++) {
+                for (int y = 0; y < size; y++) {
+                    for (int z = 0; z < size; z++) {
+                        on += pointsAreOn(points, x, y, z);
+                    }
+                }
+            }
+        }
+        sink += on;
+    }
+
+private:
+    int size;
+    std::string file;
+    std::vector<Vector3> points;
+};
+
+//! What MatrixWidget::calcCubeSize() does for one state
+class CalcCubeSize : public Benchmark
+{
+public:
+    CalcCubeSize(int size) : Benchmark(sizeName("calcCubeSize", size), 1), size(size) {}
+
+    void run(int iterations) {
+        for (int n = 0; n < iterations; n++) {
+            LatticeGeometry geometry;
+            geometry.xCubes = geometry.yCubes = geometry.zCubes = size;
+            geometry.ledSize = 1;
+            geometry.spacing = 0.5f + (n % 2);
+            geometry.points = false;
+            geometry.calculate();
+            buildBricks(geometry, bricks);
+            state.resize(geometry);
+            sink += bricks.size();
+        }
+    }
+
+private:
+    int size;
+    std::vector<Brick> bricks;
+    LatticeState state;
+};
+
+//! MatrixWidget::setFaceAnimation() without the dialog: parse and normalize a .xyz file
+class LoadPoints : public Benchmark
+{
+public:
+    LoadPoints(const std::string& name, const std::string& file, double points = 0)
+        : Benchmark(name, points), file(file) {}
+
+    bool setUp() {
+        // a missing file would time nothing, and the number of
+        // items is however many points the file has
+        std::vector<Vector3> points;
+        if (!loadXYZ(QString::fromLocal8Bit(file.c_str()), points) || points.empty()) {
+            return false;
+        }
+        items = (double) points.size();
+        return true;
+    }
+
+    void run(int iterations) {
+        for (int n = 0; n < iterations; n++) {
+            std::vector<Vector3> points;
+            loadXYZ(QString::fromLocal8Bit(file.c_str()), points);
+            normalizePoints(points, 20, 20, 20);
+            sink += points.size();
+        }
+    }
+
+protected:
+    std::string file;
+};
+
+//! LoadPoints on a generated cloud of random points
+class LoadSyntheticPoints : public LoadPoints
+{
+public:
+    LoadSyntheticPoints(long long count)
+        : LoadPoints(sizeName("load/synthetic", count), "", (double) count), count(count), temp(0) {}
+
+    bool setUp() {
+        // written in chunks so 50M points don't need 1.5GB of memory
+        temp = new QTemporaryFile;
+        if (!temp->open()) {
+            return false;
+        }
+        srand(1);
+        std::string chunk;
+        char line[96];
+        for (long long i = 0; i < count; i++) {
+            sprintf(line, "%f %f %f\n",
+                rand() * 200.0 / RAND_MAX - 100, rand() * 200.0 / RAND_MAX - 100, rand() * 200.0 / RAND_MAX - 100);
+            chunk += line;
+            if (chunk.size() > (1 << 20) || i == count - 1) {
+                temp->write(chunk.data(), chunk.size());
+                chunk.clear();
+            }
+        }
+        temp->flush();
+        file = temp->fileName().toLocal8Bit().constData();
+        return true;
+    }
+
+    void tearDown() {
+        delete temp;
+        temp = 0;
+    }
+
+private:
+    long long count;
+    QTemporaryFile* temp;
+};
+
+//! The cpu side of paintGL(): evaluate the LEDs and build the vertex arrays
+/*!
+    Covers what renderFrame() does for one state with every brick
+    visible. The OpenGL calls that follow it (one glDrawArrays() per
+    run of bricks) are left out.
+*/
+class Traversal : public Benchmark
+{
+public:
+    Traversal(int size, bool points, int level)
+        : Benchmark(traversalName(size, points, level), (double) size*size*size),
+          size(size), points(points), level(level), t(0) {}
+
+    bool setUp() {
+        geometry.xCubes = geometry.yCubes = geometry.zCubes = size;
+        geometry.ledSize = 1;
+        geometry.spacing = 0.5f;
+        geometry.points = points;
+        geometry.calculate();
+        buildBricks(geometry, bricks);
+        state.resize(geometry);
+        needed.assign(bricks.size(), 1);
+        return true;
+    }
+
+    void run(int iterations) {
+        VoxelGrid& leds = state.voxels.level(0);
+        for (int n = 0; n < iterations; n++) {
+            t += 33;
+            for (size_t b = 0; b < bricks.size(); b++) {
+                const Brick& brick = bricks[b];
+                for (int i = brick.x0; i < brick.x1; i++) {
+                    for (int j = brick.y0; j < brick.y1; j++) {
+                        for (int k = brick.z0; k < brick.z1; k++) {
+                            leds.setValue(i, j, k, waveIsOn(i, j, k, t, size, size, size) ? 255 : 0);
+                        }
+                    }
+                }
+            }
+            state.build(geometry, bricks, needed, level, 0.05f, false);
+            sink += state.vertices.size();
+        }
+    }
+
+private:
+    static std::string traversalName(int size, bool points, int level) {
+        char name[128];
+        sprintf(name, "traversal/%s/lod%d/%d", points ? "points" : "cubes", level, size);
+        return name;
+    }
+
+    int size;
+    bool points;
+    int level;
+    int t;
+    LatticeGeometry geometry;
+    std::vector<Brick> bricks;
+    std::vector<char> needed;
+    LatticeState state;
+};
+
+/*!
+    Compositor::compose() of the wave with all LEDs on. With XOR it
+    stays on the packed bits, with ADD it goes through the bytes.
+*/
+class Compose : public Benchmark
+{
+public:
+    Compose(int size, int op)
+        : Benchmark(composeName(size, op), (double) size*size*size), size(size), op(op), t(0) {}
+
+    bool setUp() {
+        compositor.addLayer(new AllOnLayer);
+        compositor.addLayer(new WaveLayer);
+        compositor.setEnabled(0, true);
+        compositor.setEnabled(1, true);
+        compositor.setOp(1, op);
+        compositor.resize(size, size, size);
+        leds.resize(size, size, size);
+        return true;
+    }
+
+    void run(int iterations) {
+        for (int n = 0; n < iterations; n++) {
+            t += 33;
+            compositor.compose(leds, t);
+            sink += leds.data()[t % (size*size*size)];
+        }
+    }
+
+private:
+    static std::string composeName(int size, int op) {
+        char name[128];
+        sprintf(name, "compose/%s/%d", op == Compositor::OP_ADD ? "add" : "xor", size);
+        return name;
+    }
+
+    int size;
+    int op;
+    int t;
+    Compositor compositor;
+    VoxelGrid leds;
+};
+
+//! LedDriver::apply() of a grayscale cube, a new table per layer every frame
+class Driver : public Benchmark
+{
+public:
+    Driver(int size, int mode)
+        : Benchmark(driverName(size, mode), (double) size*size*size), size(size), mode(mode), t(0) {}
+
+    bool setUp() {
+        DriverSettings settings;
+        settings.mode = mode;
+        driver.setSettings(settings);
+        intensity.resize(size, size, size);
+        for (int i = 0; i < size*size*size; i++) {
+            intensity.data()[i] = (unsigned char) (i*7);
+        }
+        return true;
+    }
+
+    void run(int iterations) {
+        for (int n = 0; n < iterations; n++) {
+            t += 33;
+            driver.apply(intensity, perceived, t);
+            sink += perceived.data()[t % (size*size*size)];
+        }
+    }
+
+private:
+    static std::string driverName(int size, int mode) {
+        char name[128];
+        sprintf(name, "driver/%s/%d", mode == DriverSettings::MODE_BAM ? "bam" : "pwm", size);
+        return name;
+    }
+
+    int size;
+    int mode;
+    int t;
+    LedDriver driver;
+    VoxelGrid intensity;
+    VoxelGrid perceived;
+};
+
+//! voxelizeMesh() of a closed sphere with rings*rings*2 triangles
+class Voxelize : public Benchmark
+{
+public:
+    Voxelize(int size, int rings, bool solid)
+        : Benchmark(voxelizeName(size, rings, solid), (double) rings*rings*2),
+          size(size), rings(rings), solid(solid) {}
+
+    bool setUp() {
+        // a UV sphere, the poles are made of degenerate triangles
+        const double pi = 3.14159265358979;
+        std::vector<Vector3> vertices;
+        for (int i = 0; i <= rings; i++) {
+            double theta = pi*i/rings;
+            for (int j = 0; j < 2*rings; j++) {
+                double phi = pi*j/rings;
+                Vector3 v = { (float) (sin(theta)*cos(phi)), (float) cos(theta), (float) (sin(theta)*sin(phi)) };
+                vertices.push_back(v);
+            }
+        }
+        for (int i = 0; i < rings; i++) {
+            for (int j = 0; j < 2*rings; j++) {
+                int a = i*2*rings + j, b = i*2*rings + (j + 1) % (2*rings);
+                Triangle first = { vertices[a], vertices[b], vertices[a + 2*rings] };
+                Triangle second = { vertices[b], vertices[b + 2*rings], vertices[a + 2*rings] };
+                triangles.push_back(first);
+                triangles.push_back(second);
+            }
+        }
+        plane.resize(size, size, size);
+        return true;
+    }
+
+    void run(int iterations) {
+        for (int n = 0; n < iterations; n++) {
+            voxelizeMesh(triangles, plane, solid);
+            sink += plane.data()[n % plane.wordCount()];
+        }
+    }
+
+private:
+    static std::string voxelizeName(int size, int rings, bool solid) {
+        char name[128];
+        sprintf(name, "voxelize/%s/%d/%d", solid ? "solid" : "surface", rings*rings*2, size);
+        return name;
+    }
+
+    int size;
+    int rings;
+    bool solid;
+    std::vector<Triangle> triangles;
+    BitPlane plane;
+};
+
+//! Automaton::step() of 3D Life, kept from dying out by reseeding
+class AutomatonStep : public Benchmark
+{
+public:
+    AutomatonStep(int size)
+        : Benchmark(automatonName(size), (double) size*size*size), size(size) {}
+
+    bool setUp() {
+        automaton.resize(size, size, size);
+        automaton.randomize(0.3, 1);
+        return true;
+    }
+
+    void run(int iterations) {
+        for (int n = 0; n < iterations; n++) {
+            if (!automaton.step()) {
+                automaton.randomize(0.3, n);
+            }
+            sink += automaton.test(n % size, 0, 0);
+        }
+    }
+
+private:
+    static std::string automatonName(int size) {
+        char name[128];
+        sprintf(name, "automaton/%d", size);
+        return name;
+    }
+
+    int size;
+    Automaton automaton;
+};
+
+//! ParticleSystem::update() and rasterize() of a full pool, topped up every frame
+class Particles : public Benchmark
+{
+public:
+    Particles(int size, int count)
+        : Benchmark(particlesName(size, count), count), size(size), count(count), state(1) {}
+
+    bool setUp() {
+        Vector3 gravity = { 0, -0.3f*size, 0 };
+        particles.setCapacity(count);
+        particles.setBounds(size, size, size);
+        particles.setGravity(gravity);
+        particles.setDrag(1.0f);
+        plane.resize(size, size, size);
+        return true;
+    }
+
+    void run(int iterations) {
+        for (int n = 0; n < iterations; n++) {
+            while (particles.count() < count) {
+                Vector3 p = { random()*size, random()*size, random()*size };
+                Vector3 v = { random()*10 - 5, random()*10 - 5, random()*10 - 5 };
+                particles.spawn(p, v, 0.5f + random()*5);
+            }
+            particles.update(1.0f/60);
+            plane.fill(false);
+            particles.rasterize(plane);
+            sink += plane.data()[n % plane.wordCount()];
+        }
+    }
+
+private:
+    static std::string particlesName(int size, int count) {
+        char name[128];
+        sprintf(name, "particles/%d/%d", count, size);
+        return name;
+    }
+
+    float random() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return (state >> 8) * (1.0f / 16777216.0f);
+    }
+
+    int size;
+    int count;
+    unsigned int state;
+    ParticleSystem particles;
+    BitPlane plane;
+};
+
+static void usage() {
+    printf("usage: bench [--filter NAME] [--reps N] [--warmup N] [--sample-ms MS]\n"
+           "             [--max-points N] [--face FILE] [--format json|csv]\n"
+           "\n"
+           "prints one result per line, times are per operation in nanoseconds.\n"
+           "point clouds are generated up to --max-points (up to 50000000).\n");
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string option = argv[i];
+        if (option == "--help" || option == "-h" || i + 1 >= argc) {
+            usage();
+            return option == "--help" || option == "-h" ? 0 : 1;
+        }
+        std::string value = argv[++i];
+        if (option == "--filter") {
+            options.filter = value;
+        } else if (option == "--reps") {
+            options.repetitions = std::max(1, atoi(value.c_str()));
+        } else if (option == "--warmup") {
+            options.warmup = std::max(0, atoi(value.c_str()));
+        } else if (option == "--sample-ms") {
+            options.sampleMs = atof(value.c_str());
+        } else if (option == "--max-points") {
+            options.maxPoints = atoll(value.c_str());
+        } else if (option == "--face") {
+            options.face = value;
+        } else if (option == "--format") {
+            options.csv = (value == "csv");
+        } else {
+            usage();
+            return 1;
+        }
+    }
+
+    // the face lives next to the app, the benchmark is usually run from bench/
+    if (!QFile::exists(QString::fromLocal8Bit(options.face.c_str())) && QFile::exists("../face-male.xyz")) {
+        options.face = "../face-male.xyz";
+    }
+
+    std::vector<Benchmark*> benchmarks;
+    benchmarks.push_back(new WaveIsOn(20));
+    benchmarks.push_back(new WaveIsOn(100));
+    benchmarks.push_back(new FaceIsOn(20, options.face));
+    benchmarks.push_back(new CalcCubeSize(20));
+    benchmarks.push_back(new CalcCubeSize(100));
+    benchmarks.push_back(new CalcCubeSize(256));
+    benchmarks.push_back(new LoadPoints("load/face-male", options.face));
+    const long long clouds[] = { 1000, 100000, 1000000, 10000000, 50000000 };
+    for (int i = 0; i < 5; i++) {
+        if (clouds[i] <= options.maxPoints) {
+            benchmarks.push_back(new LoadSyntheticPoints(clouds[i]));
+        }
+    }
+    benchmarks.push_back(new Traversal(20, true, 0));
+    benchmarks.push_back(new Traversal(20, false, 0));
+    benchmarks.push_back(new Traversal(100, true, 0));
+    benchmarks.push_back(new Traversal(100, false, 0));
+    benchmarks.push_back(new Traversal(100, true, 2));
+    benchmarks.push_back(new Traversal(100, false, 2));
+    benchmarks.push_back(new Compose(100, Compositor::OP_XOR));
+    benchmarks.push_back(new Compose(100, Compositor::OP_ADD));
+    benchmarks.push_back(new Compose(256, Compositor::OP_XOR));
+    benchmarks.push_back(new Compose(256, Compositor::OP_ADD));
+    benchmarks.push_back(new Driver(100, DriverSettings::MODE_BAM));
+    benchmarks.push_back(new Driver(100, DriverSettings::MODE_PWM));
+    benchmarks.push_back(new Driver(256, DriverSettings::MODE_BAM));
+    benchmarks.push_back(new Voxelize(100, 100, false));
+    benchmarks.push_back(new Voxelize(100, 100, true));
+    benchmarks.push_back(new Voxelize(256, 700, false));
+    benchmarks.push_back(new Voxelize(256, 700, true));
+    benchmarks.push_back(new AutomatonStep(100));
+    benchmarks.push_back(new AutomatonStep(256));
+    benchmarks.push_back(new Particles(100, 100000));
+    benchmarks.push_back(new Particles(256, 1000000));
+
+    printHeader(options);
+    for (size_t i = 0; i < benchmarks.size(); i++) {
+        runBenchmark(*benchmarks[i], options);
+        delete benchmarks[i];
+    }
+    return 0;
+}
@@ -0,0 +1,15 @@
+######################################################################
+# Microbenchmarks for the hot paths of the simulation.
+# Build with: cd bench && qmake && make && ./bench
+######################################################################
+QT -= gui
+CONFIG += console
+CONFIG -= app_bundle
+TEMPLATE = app
+TARGET = bench
+DEPENDPATH += . ..
+INCLUDEPATH += . ..
+
+# Input
+HEADERS += ../frustum.h ../voxelgrid.h ../lattice.h ../animations.h ../bitplane.h ../compositor.h ../layers.h ../driver.h ../mesh.h ../automaton.h ../particles.h
+SOURCES += bench.cpp ../frustum.cpp ../voxelgrid.cpp ../lattice.cpp ../animations.cpp ../bitplane.cpp ../compositor.cpp ../layers.cpp ../driver.cpp ../mesh.cpp ../automaton.cpp ../particles.cpp
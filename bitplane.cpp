@@ -0,0 +1,70 @@
+/*  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
+
+ > BitPlane class, the on/off state of every LED packed into 64 bit
+ > words so that whole planes can be combined a word at a time.
+
+ > Copyright (C) 2014 by Daniel Intskirveli, Gurpreet Singh, Christopher Zhang.
+
+ > bitplane.cpp - packed on/off state of the cube.
+
+ > Written by: Daniel Intskirveli, Gurpreet Singh, Christopher Zhang, 2014.
+
+  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_ */
+
+#include "bitplane.h"
+#include <algorithm>
+#include <cstring>
+
+// 8 bits -> 8 bytes of 0 or 255, so expand() handles 8 LEDs per lookup
+struct ExpandTable {
+    unsigned char bytes[256][8];
+
+    ExpandTable() {
+        for (int b = 0; b < 256; b++) {
+            for (int bit = 0; bit < 8; bit++) {
+                bytes[b][bit] = (b >> bit) & 1 ? 255 : 0;
+            }
+        }
+    }
+};
+static const ExpandTable expandTable;
+
+BitPlane::BitPlane() : w(0), h(0), d(0) {
+}
+
+void BitPlane::resize(int width, int height, int depth) {
+    w = width;
+    h = height;
+    d = depth;
+    words.assign(((size_t) w*h*d + 63) / 64, 0);
+}
+
+void BitPlane::fill(bool on) {
+    std::fill(words.begin(), words.end(), on ? ~(Word) 0 : 0);
+
+    // keep the bits after the last LED cleared
+    int used = (w*h*d) & 63;
+    if (on && used) {
+        words.back() = ((Word) 1 << used) - 1;
+    }
+}
+
+void BitPlane::expand(unsigned char* bytes) const {
+    int count = w*h*d;
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        int b = (int) (words[i >> 6] >> (i & 63)) & 0xff;
+        memcpy(bytes + i, expandTable.bytes[b], 8);
+    }
+    for (; i < count; i++) {
+        bytes[i] = (words[i >> 6] >> (i & 63)) & 1 ? 255 : 0;
+    }
+}
+
+void BitPlane::pack(const unsigned char* bytes) {
+    int count = w*h*d;
+    std::fill(words.begin(), words.end(), 0);
+    for (int i = 0; i < count; i++) {
+        words[i >> 6] |= (Word) (bytes[i] != 0) << (i & 63);
+    }
+}
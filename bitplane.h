@@ -0,0 +1,66 @@
+/*  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
+
+ > BitPlane class, the on/off state of every LED packed into 64 bit
+ > words so that whole planes can be combined a word at a time.
+
+ > Copyright (C) 2014 by Daniel Intskirveli, Gurpreet Singh, Christopher Zhang.
+
+ > bitplane.h - packed on/off state of the cube.
+
+ > Written by: Daniel Intskirveli, Gurpreet Singh, Christopher Zhang, 2014.
+
+  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_ */
+
+#ifndef BITPLANE_H
+#define BITPLANE_H
+
+#include <vector>
+
+//! One bit per LED
+/*!
+    Bits are in the same order as the values of a VoxelGrid, bit i is in
+    word i/64. The bits after the last LED are always 0, so planes can be
+    combined word by word without looking at the size.
+*/
+class BitPlane
+{
+public:
+    typedef unsigned long long Word;
+
+    BitPlane();
+
+    void resize(int width, int height, int depth);
+    void fill(bool on);
+
+    int width() const { return w; }
+    int height() const { return h; }
+    int depth() const { return d; }
+    int index(int x, int y, int z) const { return (x*h + y)*d + z; }
+
+    bool test(int x, int y, int z) const {
+        int i = index(x, y, z);
+        return (words[i >> 6] >> (i & 63)) & 1;
+    }
+    void set(int x, int y, int z) {
+        int i = index(x, y, z);
+        words[i >> 6] |= (Word) 1 << (i & 63);
+    }
+
+    int wordCount() const { return (int) words.size(); }
+    Word* data() { return words.empty() ? 0 : &words[0]; }
+    const Word* data() const { return words.empty() ? 0 : &words[0]; }
+
+    // writes 255 for every LED that is on and 0 for every LED that is off
+    void expand(unsigned char* bytes) const;
+
+    // the other way around, every LED that isn't 0 is on
+    void pack(const unsigned char* bytes);
+
+private:
+    int w;
+    int h;
+    int d;
+    std::vector<Word> words;
+};
+
+#endif
@@ -0,0 +1,202 @@
+/*  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
+
+ > Compositor class which stacks animation layers on top of each other
+ > and combines them into the state of the LEDs.
+
+ > Copyright (C) 2014 by Daniel Intskirveli, Gurpreet Singh, Christopher Zhang.
+
+ > compositor.cpp - layered animations.
+
+ > Written by: Daniel Intskirveli, Gurpreet Singh, Christopher Zhang, 2014.
+
+  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_ */
+
+#include "compositor.h"
+#include <algorithm>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+void Layer::resize(int, int, int) {
+}
+
+void Layer::render(BitPlane&, int) {
+}
+
+void Layer::renderBrightness(VoxelGrid&, int) {
+}
+
+Compositor::Compositor() : changes(0) {
+}
+
+Compositor::~Compositor() {
+    for (size_t n = 0; n < layers.size(); n++) {
+        delete layers[n].layer;
+    }
+}
+
+int Compositor::addLayer(Layer* layer) {
+    Entry entry;
+    entry.layer = layer;
+    entry.enabled = false;
+    entry.op = OP_OR;
+    layers.push_back(entry);
+    if (grid.width() > 0) {
+        layer->resize(grid.width(), grid.height(), grid.depth());
+    }
+    return layers.size() - 1;
+}
+
+void Compositor::setEnabled(int n, bool enabled) {
+    layers[n].enabled = enabled;
+    changed();
+}
+
+void Compositor::setOp(int n, int op) {
+    layers[n].op = op;
+    changed();
+}
+
+void Compositor::resize(int width, int height, int depth) {
+    bits.resize(width, height, depth);
+    plane.resize(width, height, depth);
+    grid.resize(width, height, depth);
+    for (size_t n = 0; n < layers.size(); n++) {
+        layers[n].layer->resize(width, height, depth);
+    }
+    changed();
+}
+
+bool Compositor::isAnimated() const {
+    for (size_t n = 0; n < layers.size(); n++) {
+        if (layers[n].enabled && layers[n].layer->isAnimated()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Compositor::compose(VoxelGrid& result, int t) {
+    bool first = true;                                      // the first layer is copied, not combined
+    bool bytes = false;                                     // result is in the grid, not in bits
+    int count = result.width()*result.height()*result.depth();
+
+    for (size_t n = 0; n < layers.size(); n++) {
+        if (!layers[n].enabled) {
+            continue;
+        }
+        Layer* layer = layers[n].layer;
+        int op = layers[n].op;
+
+        if (!bytes && !layer->hasBrightness() && op != OP_ADD) {
+            // everything so far is on or off: 64 LEDs per operation
+            plane.fill(false);
+            layer->render(plane, t);
+            if (first) {
+                std::copy(plane.data(), plane.data() + plane.wordCount(), bits.data());
+            } else {
+                combineBits(bits.data(), plane.data(), plane.wordCount(), op);
+            }
+        } else {
+            // switch over to bytes, the result so far becomes 0 / 255
+            if (!bytes) {
+                if (first) {
+                    result.fill(0);
+                } else {
+                    bits.expand(result.data());
+                }
+                bytes = true;
+            }
+            if (layer->hasBrightness()) {
+                grid.fill(0);
+                layer->renderBrightness(grid, t);
+            } else {
+                plane.fill(false);
+                layer->render(plane, t);
+                plane.expand(grid.data());
+            }
+            if (first) {
+                std::copy(grid.data(), grid.data() + count, result.data());
+            } else {
+                combineBytes(result.data(), grid.data(), count, op);
+            }
+        }
+        first = false;
+    }
+
+    if (first) {
+        // no layers, everything is off
+        result.fill(0);
+    } else if (!bytes) {
+        bits.expand(result.data());
+    }
+}
+
+void Compositor::combineBits(BitPlane::Word* result, const BitPlane::Word* layer, int count, int op) {
+    // simple loops over whole words, the compiler turns
+    // these into SIMD instructions where it can
+    switch (op) {
+    case OP_OR:
+        for (int i = 0; i < count; i++) result[i] |= layer[i];
+        break;
+    case OP_AND:
+        for (int i = 0; i < count; i++) result[i] &= layer[i];
+        break;
+    case OP_XOR:
+        for (int i = 0; i < count; i++) result[i] ^= layer[i];
+        break;
+    case OP_MASK:
+        for (int i = 0; i < count; i++) result[i] &= ~layer[i];
+        break;
+    }
+}
+
+// one LED of combineBytes(), for the ones that don't fill a whole SSE2 register
+static unsigned char combineByte(unsigned char r, unsigned char v, int op) {
+    switch (op) {
+    case Compositor::OP_OR:   return std::max(r, v);
+    case Compositor::OP_AND:  return v ? r : 0;
+    case Compositor::OP_XOR:  return v ? (r ? 0 : v) : r;
+    case Compositor::OP_MASK: return v ? 0 : r;
+    case Compositor::OP_ADD:  return (unsigned char) std::min(255, r + v);
+    }
+    return r;
+}
+
+void Compositor::combineBytes(unsigned char* result, const unsigned char* layer, int count, int op) {
+    // with brightness, OR keeps the brighter one, AND and MASK keep or
+    // clear what is below wherever the layer is on, XOR lights the
+    // layer where nothing was on before, and ADD adds up, saturating.
+    int i = 0;
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= count; i += 16) {
+        __m128i r = _mm_loadu_si128((const __m128i*) (result + i));
+        __m128i v = _mm_loadu_si128((const __m128i*) (layer + i));
+        __m128i off = _mm_cmpeq_epi8(v, zero);              // 0xff where the layer is off
+        switch (op) {
+        case OP_OR:
+            r = _mm_max_epu8(r, v);
+            break;
+        case OP_AND:
+            r = _mm_andnot_si128(off, r);
+            break;
+        case OP_XOR:
+            r = _mm_or_si128(_mm_and_si128(off, r),
+                             _mm_and_si128(_mm_cmpeq_epi8(r, zero), v));
+            break;
+        case OP_MASK:
+            r = _mm_and_si128(off, r);
+            break;
+        case OP_ADD:
+            r = _mm_adds_epu8(r, v);
+            break;
+        }
+        _mm_storeu_si128((__m128i*) (result + i), r);
+    }
+#endif
+    for (; i < count; i++) {
+        result[i] = combineByte(result[i], layer[i], op);
+    }
+}
@@ -0,0 +1,102 @@
+/*  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
+
+ > Compositor class which stacks animation layers on top of each other
+ > and combines them into the state of the LEDs.
+
+ > Copyright (C) 2014 by Daniel Intskirveli, Gurpreet Singh, Christopher Zhang.
+
+ > compositor.h - layered animations.
+
+ > Written by: Daniel Intskirveli, Gurpreet Singh, Christopher Zhang, 2014.
+
+  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_ */
+
+#ifndef COMPOSITOR_H
+#define COMPOSITOR_H
+
+#include <string>
+#include <vector>
+#include "bitplane.h"
+#include "voxelgrid.h"
+
+//! An animation that can be stacked in the Compositor
+/*!
+    A layer draws a whole frame at once. Most layers only know on and off
+    and draw into a BitPlane, layers that have brightness draw into a
+    VoxelGrid instead and return true from hasBrightness().
+*/
+class Layer
+{
+public:
+    virtual ~Layer() {}
+
+    virtual std::string name() const = 0;
+    virtual bool isAnimated() const { return false; }       // whether frames depend on the time
+    virtual bool hasBrightness() const { return false; }
+    virtual void resize(int width, int height, int depth);
+
+    // compose() runs once for every cube of a wall, each shifted by
+    // the wall phase, so t can go back a little within a frame. layers
+    // that step a simulation step it only when t is newer than before,
+    // and start over when t goes back further than a wall spreads it
+    // (16 x 16 cubes a second apart), such as an export starting at 0
+    enum { RESTART_MS = 300000 };
+
+    // the plane / grid has the size of the cube, is cleared, and
+    // t is the time in milliseconds
+    virtual void render(BitPlane& plane, int t);
+    virtual void renderBrightness(VoxelGrid& grid, int t);
+};
+
+//! Stack of layers
+/*!
+    The first enabled layer is the base, every following one is combined
+    with what is below it. Layers are combined 64 LEDs at a time as long
+    as everything is on or off, once a layer with brightness or an ADD
+    comes along the rest is combined as bytes, 16 at a time with SSE2.
+*/
+class Compositor
+{
+public:
+    enum { OP_OR, OP_AND, OP_XOR, OP_MASK, OP_ADD };      // MASK turns off what the layer turns on
+
+    Compositor();
+    ~Compositor();
+
+    int addLayer(Layer* layer);                             // takes ownership, returns the index
+    int layerCount() const { return (int) layers.size(); }
+    Layer* layer(int n) { return layers[n].layer; }
+    const Layer* layer(int n) const { return layers[n].layer; }
+
+    void setEnabled(int n, bool enabled);
+    bool isEnabled(int n) const { return layers[n].enabled; }
+    void setOp(int n, int op);
+    int op(int n) const { return layers[n].op; }
+
+    void resize(int width, int height, int depth);
+    bool isAnimated() const;
+
+    // bumped whenever the result for the same t could change
+    int version() const { return changes; }
+    void changed() { changes++; }
+
+    void compose(VoxelGrid& result, int t);
+
+private:
+    struct Entry {
+        Layer* layer;
+        bool enabled;
+        int op;
+    };
+
+    static void combineBits(BitPlane::Word* result, const BitPlane::Word* layer, int count, int op);
+    static void combineBytes(unsigned char* result, const unsigned char* layer, int count, int op);
+
+    std::vector<Entry> layers;
+    BitPlane bits;                                          // result while everything is on or off
+    BitPlane plane;                                         // the layer being combined
+    VoxelGrid grid;                                         // the layer being combined, as bytes
+    int changes;
+};
+
+#endif
@@ -0,0 +1,112 @@
+/*  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
+
+ > LedDriver class which simulates how the driver of a real cube shows
+ > 8 bit brightness: bit angle modulation or PWM, one layer at a time.
+
+ > Copyright (C) 2014 by Daniel Intskirveli, Gurpreet Singh, Christopher Zhang.
+
+ > driver.cpp - brightness the eye (or a camera) sees over a display period.
+
+ > Written by: Daniel Intskirveli, Gurpreet Singh, Christopher Zhang, 2014.
+
+  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_ */
+
+#include "driver.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+DriverSettings::DriverSettings()
+    : mode(MODE_OFF), bits(8), refreshRate(120), exposure(1000/60.0), multiplex(true) {
+}
+
+LedDriver::LedDriver() {
+}
+
+void LedDriver::setSettings(const DriverSettings& settings) {
+    current = settings;
+    current.bits = std::max(1, std::min(8, current.bits));
+    current.refreshRate = std::max(1.0, current.refreshRate);
+}
+
+// ticks in [0, x) that fall into [first, first + length) of every cycle
+static double covered(double x, double first, double length, double period) {
+    double cycles = floor(x / period);
+    double rest = x - cycles*period;
+    return cycles*length + std::min(length, std::max(0.0, rest - first));
+}
+
+void LedDriver::updateTables(int layers, int t) {
+    int bits = current.bits;
+    int levels = (1 << bits) - 1;                           // ticks of one layer in a cycle
+    double period = 1000.0 / current.refreshRate;
+    double ticks = (double) levels * layers;                // ticks in a cycle
+    double tick = period / ticks;
+
+    // the exposure in ticks from the start of the cycle it begins in.
+    // at least one tick, so that a fully on LED is seen at all
+    double start = fmod((double) t, period) / tick;
+    double end = start + std::max(current.exposure, tick) / tick;
+    double full = (end - start) / layers;                   // ticks a fully on LED is on
+
+    tables.resize(layers*256);
+    onTime.resize(levels + 1);
+    for (int y = 0; y < layers; y++) {
+        onTime[0] = 0;
+        if (current.mode == DriverSettings::MODE_BAM) {
+            // bit b of layer y starts after every layer showed the bits below
+            // it, and after the layers before y showed bit b
+            for (int b = 0; b < bits; b++) {
+                double first = (double) layers*((1 << b) - 1) + y*(1 << b);
+                double on = covered(end, first, 1 << b, ticks) - covered(start, first, 1 << b, ticks);
+                // the intensities with b as their highest bit
+                for (int q = 1 << b; q < (2 << b); q++) {
+                    onTime[q] = onTime[q - (1 << b)] + on;
+                }
+            }
+        } else {
+            for (int q = 1; q <= levels; q++) {
+                onTime[q] = covered(end, (double) y*levels, q, ticks) - covered(start, (double) y*levels, q, ticks);
+            }
+        }
+
+        // the driver only sees the top bits of the intensity
+        unsigned char* table = &tables[y*256];
+        for (int v = 0; v < 256; v++) {
+            double seen = onTime[v >> (8 - bits)] / full;
+            table[v] = (unsigned char) (255*std::min(1.0, seen) + 0.5);
+        }
+    }
+}
+
+void LedDriver::apply(const VoxelGrid& intensity, VoxelGrid& perceived, int t) {
+    int w = intensity.width();
+    int h = intensity.height();
+    int d = intensity.depth();
+    if (perceived.width() != w || perceived.height() != h || perceived.depth() != d) {
+        perceived.resize(w, h, d);
+    }
+    if (w*h*d == 0) {
+        return;
+    }
+    if (!isEnabled()) {
+        memcpy(perceived.data(), intensity.data(), (size_t) w*h*d);
+        return;
+    }
+
+    updateTables(current.multiplex ? h : 1, t);
+
+    // z is the inner loop, so every run of d LEDs shares a layer and a table
+    const unsigned char* in = intensity.data();
+    unsigned char* out = perceived.data();
+    for (int x = 0; x < w; x++) {
+        for (int y = 0; y < h; y++) {
+            const unsigned char* lookup = table(y);
+            for (int z = 0; z < d; z++) {
+                out[z] = lookup[in[z]];
+            }
+            in += d;
+            out += d;
+        }
+    }
+}
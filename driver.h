@@ -0,0 +1,70 @@
+/*  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
+
+ > LedDriver class which simulates how the driver of a real cube shows
+ > 8 bit brightness: bit angle modulation or PWM, one layer at a time.
+
+ > Copyright (C) 2014 by Daniel Intskirveli, Gurpreet Singh, Christopher Zhang.
+
+ > driver.h - brightness the eye (or a camera) sees over a display period.
+
+ > Written by: Daniel Intskirveli, Gurpreet Singh, Christopher Zhang, 2014.
+
+  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_ */
+
+#ifndef DRIVER_H
+#define DRIVER_H
+
+#include <vector>
+#include "voxelgrid.h"
+
+//! How the simulated driver refreshes the cube
+struct DriverSettings {
+    enum { MODE_OFF, MODE_BAM, MODE_PWM };                  // OFF shows the intensities as they are
+
+    int mode;
+    int bits;                                               // resolution of the driver, 1 - 8
+    double refreshRate;                                     // whole refresh cycles per second
+    double exposure;                                        // milliseconds a frame integrates over
+    bool multiplex;                                         // one y layer lit at a time
+
+    DriverSettings();
+};
+
+//! Turns LED intensities into the brightness seen over one frame
+/*!
+    A cycle is split into ticks. With BAM every bit of the intensity is
+    shown for 2^bit ticks, lowest bit first, and every bit is shown for
+    each layer in turn when multiplexing. With PWM every layer gets
+    2^bits - 1 ticks and an LED is on for the first intensity of them.
+
+    What is seen in a frame is how long an LED was on during the exposure
+    [t, t + exposure), relative to an LED that is fully on. That depends
+    only on the layer and the intensity, so apply() works out a table of
+    256 entries per layer once per frame and looks every LED up in it.
+    When the exposure is not a whole number of cycles this is what makes
+    the flicker and banding of a real cube show up.
+*/
+class LedDriver
+{
+public:
+    LedDriver();
+
+    void setSettings(const DriverSettings& settings);
+    const DriverSettings& settings() const { return current; }
+    bool isEnabled() const { return current.mode != DriverSettings::MODE_OFF; }
+
+    // perceived gets the size of intensity, t is the time in milliseconds
+    void apply(const VoxelGrid& intensity, VoxelGrid& perceived, int t);
+
+    // the table of layer y for the last t passed to apply()
+    const unsigned char* table(int y) const { return &tables[current.multiplex ? y*256 : 0]; }
+
+private:
+    void updateTables(int layers, int t);
+
+    DriverSettings current;
+    std::vector<unsigned char> tables;                      // 256 entries per layer
+    std::vector<double> onTime;                             // ticks on per quantized intensity
+};
+
+#endif
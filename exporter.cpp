@@ -0,0 +1,292 @@
+/*  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
+
+ > FrameExporter class for writing rendered frames of an animation to
+ > disk as a PNG sequence or a raw Y4M video.
+
+ > Copyright (C) 2014 by Daniel Intskirveli, Gurpreet Singh, Christopher Zhang.
+
+ > exporter.cpp - image sequence and video export.
+
+ > Written by: Daniel Intskirveli, Gurpreet Singh, Christopher Zhang, 2014.
+
+  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_ */
+
+#include "exporter.h"
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QMap>
+#include <QFile>
+#include <QDir>
+#include <QImage>
+
+ExportSettings::ExportSettings() {
+    format = FORMAT_PNG;
+    frames = 300;
+    fps = 30.0;
+    speed = 1.0;
+    width = 1280;
+    height = 720;
+    threads = QThread::idealThreadCount() > 1 ? QThread::idealThreadCount() - 1 : 1;
+}
+
+// a frame as read back from the framebuffer
+struct ExportFrame {
+    int index;
+    QByteArray pixels;
+};
+
+//! Bounded queue between the render loop and the encoder threads
+class FrameQueue
+{
+public:
+    FrameQueue(int capacity) : capacity(capacity), closed(false) {}
+
+    // blocks while the queue is full
+    void push(const ExportFrame& frame) {
+        QMutexLocker locker(&mutex);
+        while (frames.count() >= capacity) {
+            notFull.wait(&mutex);
+        }
+        frames.append(frame);
+        notEmpty.wakeOne();
+    }
+
+    // blocks while the queue is empty, returns false
+    // once it is closed and there is nothing left
+    bool pop(ExportFrame& frame) {
+        QMutexLocker locker(&mutex);
+        while (frames.isEmpty() && !closed) {
+            notEmpty.wait(&mutex);
+        }
+        if (frames.isEmpty()) {
+            return false;
+        }
+        frame = frames.takeFirst();
+        notFull.wakeOne();
+        return true;
+    }
+
+    void close() {
+        QMutexLocker locker(&mutex);
+        closed = true;
+        notEmpty.wakeAll();
+    }
+
+private:
+    int capacity;
+    bool closed;
+    QList<ExportFrame> frames;
+    QMutex mutex;
+    QWaitCondition notEmpty;
+    QWaitCondition notFull;
+};
+
+//! Appends encoded pictures to a Y4M file in the order of the frames
+class Y4MWriter : public QThread
+{
+public:
+    Y4MWriter(int capacity) : capacity(capacity), next(0), closed(false), failed(false) {}
+
+    bool open(const ExportSettings& settings) {
+        file.setFileName(settings.path);
+        if (!file.open(QIODevice::WriteOnly)) {
+            return false;
+        }
+        // C420jpeg: full range BT.601, chroma sited like JPEG does
+        QByteArray header = QString("YUV4MPEG2 W%1 H%2 F%3:1000 Ip A1:1 C420jpeg\n")
+            .arg(settings.width).arg(settings.height).arg(qRound(settings.fps*1000)).toLatin1();
+        return file.write(header) == header.size();
+    }
+
+    // blocks while too many frames are waiting for an earlier one
+    void submit(int index, const QByteArray& picture) {
+        QMutexLocker locker(&mutex);
+        while (pending.count() >= capacity && index != next) {
+            changed.wait(&mutex);
+        }
+        pending.insert(index, picture);
+        changed.wakeAll();
+    }
+
+    void close() {
+        QMutexLocker locker(&mutex);
+        closed = true;
+        changed.wakeAll();
+    }
+
+    bool hasFailed() const { return failed; }
+
+protected:
+    void run() {
+        forever {
+            QByteArray picture;
+            {
+                QMutexLocker locker(&mutex);
+                while (!pending.contains(next) && !(closed && pending.isEmpty())) {
+                    changed.wait(&mutex);
+                }
+                if (!pending.contains(next)) {
+                    break;
+                }
+                picture = pending.take(next);
+                next++;
+                changed.wakeAll();
+            }
+            if (file.write("FRAME\n", 6) != 6 || file.write(picture) != picture.size()) {
+                failed = true;
+            }
+        }
+        file.close();
+    }
+
+private:
+    int capacity;
+    int next;
+    bool closed;
+    bool failed;
+    QFile file;
+    QMap<int, QByteArray> pending;
+    QMutex mutex;
+    QWaitCondition changed;
+};
+
+// full range BT.601 RGB -> YUV 4:2:0, with the rows flipped
+// because glReadPixels() returns the bottom row first
+static QByteArray toYUV420(const QByteArray& pixels, int width, int height) {
+    QByteArray picture(width*height*3/2, '\0');
+    unsigned char* yPlane = (unsigned char*) picture.data();
+    unsigned char* uPlane = yPlane + width*height;
+    unsigned char* vPlane = uPlane + width*height/4;
+    const unsigned char* bgra = (const unsigned char*) pixels.constData();
+
+    for (int y = 0; y < height; y += 2) {
+        const unsigned char* row0 = bgra + (height - 1 - y)*width*4;
+        const unsigned char* row1 = row0 - width*4;
+        for (int x = 0; x < width; x += 2) {
+            int r = 0, g = 0, b = 0;
+            for (int i = 0; i < 4; i++) {
+                const unsigned char* p = (i < 2 ? row0 : row1) + (x + i % 2)*4;
+                int luma = (19595*p[2] + 38470*p[1] + 7471*p[0] + 32768) >> 16;
+                yPlane[(y + i / 2)*width + x + i % 2] = (unsigned char) luma;
+                r += p[2];
+                g += p[1];
+                b += p[0];
+            }
+            int u = 128 + ((-11059*r - 21709*g + 32768*b + 131072) >> 18);
+            int v = 128 + ((32768*r - 27439*g - 5329*b + 131072) >> 18);
+            uPlane[(y/2)*(width/2) + x/2] = (unsigned char) qBound(0, u, 255);
+            vPlane[(y/2)*(width/2) + x/2] = (unsigned char) qBound(0, v, 255);
+        }
+    }
+    return picture;
+}
+
+//! Takes frames from the queue and encodes them
+class EncoderThread : public QThread
+{
+public:
+    EncoderThread(const ExportSettings& settings, FrameQueue* queue, Y4MWriter* writer)
+        : settings(settings), queue(queue), writer(writer), failed(false) {}
+
+    bool hasFailed() const { return failed; }
+
+protected:
+    void run() {
+        ExportFrame frame;
+        while (queue->pop(frame)) {
+            if (settings.format == ExportSettings::FORMAT_Y4M) {
+                writer->submit(frame.index, toYUV420(frame.pixels, settings.width, settings.height));
+            } else {
+                // BGRA bytes are what QImage::Format_RGB32 is on little endian
+                // machines, mirrored() makes a flipped copy so the image
+                // doesn't point into the frame anymore when it is saved
+                QImage image((const uchar*) frame.pixels.constData(),
+                    settings.width, settings.height, QImage::Format_RGB32);
+                QString name = QString("frame_%1.png").arg(frame.index, 5, 10, QChar('0'));
+                if (!image.mirrored().save(QDir(settings.path).filePath(name), "PNG")) {
+                    failed = true;
+                }
+            }
+        }
+    }
+
+private:
+    ExportSettings settings;
+    FrameQueue* queue;
+    Y4MWriter* writer;
+    bool failed;
+};
+
+FrameExporter::FrameExporter(const ExportSettings& settings) : settings(settings) {
+    this->settings.threads = qMax(1, settings.threads);
+    frameCount = 0;
+    queue = new FrameQueue(2*this->settings.threads);
+    writer = 0;
+    encoders = new EncoderThread*[this->settings.threads];
+    for (int i = 0; i < this->settings.threads; i++) {
+        encoders[i] = 0;
+    }
+}
+
+FrameExporter::~FrameExporter() {
+    for (int i = 0; i < settings.threads; i++) {
+        delete encoders[i];
+    }
+    delete[] encoders;
+    delete writer;
+    delete queue;
+}
+
+bool FrameExporter::start() {
+    if (settings.format == ExportSettings::FORMAT_Y4M) {
+        // 4:2:0 needs an even width and height
+        if (settings.width % 2 || settings.height % 2) {
+            error = "Y4M export needs an even width and height";
+            return false;
+        }
+        writer = new Y4MWriter(4*settings.threads);
+        if (!writer->open(settings)) {
+            error = "could not open " + settings.path;
+            return false;
+        }
+        writer->start();
+    } else if (!QDir().mkpath(settings.path)) {
+        error = "could not create " + settings.path;
+        return false;
+    }
+
+    for (int i = 0; i < settings.threads; i++) {
+        encoders[i] = new EncoderThread(settings, queue, writer);
+        encoders[i]->start();
+    }
+    return true;
+}
+
+void FrameExporter::addFrame(const QByteArray& pixels) {
+    ExportFrame frame;
+    frame.index = frameCount++;
+    frame.pixels = pixels;
+    queue->push(frame);
+}
+
+bool FrameExporter::finish() {
+    // let the encoders drain the queue, then the writer
+    queue->close();
+    bool ok = true;
+    for (int i = 0; i < settings.threads; i++) {
+        if (encoders[i]) {
+            encoders[i]->wait();
+            ok = ok && !encoders[i]->hasFailed();
+        }
+    }
+    if (writer) {
+        writer->close();
+        writer->wait();
+        ok = ok && !writer->hasFailed();
+    }
+    if (!ok) {
+        error = "could not write all frames to " + settings.path;
+    }
+    return ok;
+}
@@ -0,0 +1,68 @@
+/*  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
+
+ > FrameExporter class for writing rendered frames of an animation to
+ > disk as a PNG sequence or a raw Y4M video.
+
+ > Copyright (C) 2014 by Daniel Intskirveli, Gurpreet Singh, Christopher Zhang.
+
+ > exporter.h - image sequence and video export.
+
+ > Written by: Daniel Intskirveli, Gurpreet Singh, Christopher Zhang, 2014.
+
+  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_ */
+
+#ifndef EXPORTER_H
+#define EXPORTER_H
+
+#include <QString>
+#include <QByteArray>
+
+class FrameQueue;
+class EncoderThread;
+class Y4MWriter;
+
+//! What to export and how
+struct ExportSettings {
+    enum { FORMAT_PNG, FORMAT_Y4M };
+
+    ExportSettings();
+
+    QString path;                                           // directory for PNG, file for Y4M
+    int format;
+    int frames;                                             // number of frames to render
+    double fps;                                             // frames per second of the result
+    double speed;                                           // animation time per second of the result, 1 is realtime
+    int width;
+    int height;
+    int threads;                                            // number of encoder threads
+};
+
+//! Writes rendered frames to disk
+/*!
+    Frames are handed to a bounded queue, encoder threads take them from
+    there and turn them into PNG files or YUV 4:2:0 pictures, and for Y4M
+    a writer thread appends the pictures to the file in order. So while
+    the next frame is rendered and read back, earlier ones are encoded
+    and written, and addFrame() only blocks when the encoders fall behind.
+*/
+class FrameExporter
+{
+public:
+    FrameExporter(const ExportSettings& settings);
+    ~FrameExporter();
+
+    bool start();
+    void addFrame(const QByteArray& pixels);                // BGRA, bottom row first, as glReadPixels() returns them
+    bool finish();
+    QString errorString() const { return error; }
+
+private:
+    ExportSettings settings;
+    QString error;
+    int frameCount;
+    FrameQueue* queue;
+    Y4MWriter* writer;
+    EncoderThread** encoders;
+};
+
+#endif
@@ -0,0 +1,128 @@
+/*  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
+
+ > Matrix and view frustum helpers used to cull parts of the LED lattice
+ > that are outside of the current view.
+
+ > Copyright (C) 2014 by Daniel Intskirveli, Gurpreet Singh, Christopher Zhang.
+
+ > frustum.cpp - 4x4 matrices and frustum/bounding box intersection tests.
+
+ > Written by: Daniel Intskirveli, Gurpreet Singh, Christopher Zhang, 2014.
+
+  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_ */
+
+#include "frustum.h"
+#include <cmath>
+
+// identity matrix
+Matrix4::Matrix4() {
+    for (int i = 0; i < 16; i++) {
+        m[i] = (i % 5 == 0) ? 1.0f : 0.0f;
+    }
+}
+
+// same matrix as glFrustum() builds
+Matrix4 Matrix4::frustum(float l, float r, float b, float t, float n, float f) {
+    Matrix4 res;
+    res.m[0]  = 2*n / (r - l);
+    res.m[5]  = 2*n / (t - b);
+    res.m[8]  = (r + l) / (r - l);
+    res.m[9]  = (t + b) / (t - b);
+    res.m[10] = -(f + n) / (f - n);
+    res.m[11] = -1;
+    res.m[14] = -2*f*n / (f - n);
+    res.m[15] = 0;
+    return res;
+}
+
+// same matrix as glTranslatef() builds
+Matrix4 Matrix4::translation(float x, float y, float z) {
+    Matrix4 res;
+    res.m[12] = x;
+    res.m[13] = y;
+    res.m[14] = z;
+    return res;
+}
+
+// same matrix as glRotatef() builds, angle is in degrees
+Matrix4 Matrix4::rotation(float angle, float x, float y, float z) {
+    Matrix4 res;
+    float len = sqrt(x*x + y*y + z*z);
+    if (len == 0) {
+        return res;
+    }
+    x /= len;
+    y /= len;
+    z /= len;
+
+    float rad = angle * 3.14159265358979f / 180.0f;
+    float c = cos(rad);
+    float s = sin(rad);
+    float ic = 1 - c;
+
+    res.m[0]  = x*x*ic + c;
+    res.m[1]  = y*x*ic + z*s;
+    res.m[2]  = x*z*ic - y*s;
+    res.m[4]  = x*y*ic - z*s;
+    res.m[5]  = y*y*ic + c;
+    res.m[6]  = y*z*ic + x*s;
+    res.m[8]  = x*z*ic + y*s;
+    res.m[9]  = y*z*ic - x*s;
+    res.m[10] = z*z*ic + c;
+    return res;
+}
+
+Matrix4 Matrix4::operator*(const Matrix4& other) const {
+    Matrix4 res;
+    for (int col = 0; col < 4; col++) {
+        for (int row = 0; row < 4; row++) {
+            float sum = 0;
+            for (int k = 0; k < 4; k++) {
+                sum += at(row, k) * other.at(k, col);
+            }
+            res.m[col*4 + row] = sum;
+        }
+    }
+    return res;
+}
+
+Vector3 Matrix4::transform(const Vector3& v) const {
+    Vector3 res;
+    res.x = m[0]*v.x + m[4]*v.y + m[8]*v.z  + m[12];
+    res.y = m[1]*v.x + m[5]*v.y + m[9]*v.z  + m[13];
+    res.z = m[2]*v.x + m[6]*v.y + m[10]*v.z + m[14];
+    return res;
+}
+
+void Frustum::set(const Matrix4& pm) {
+    // Gribb/Hartmann plane extraction: each clip plane is the
+    // last row of the matrix plus or minus one of the other rows.
+    // the order is left, right, bottom, top, near, far.
+    for (int i = 0; i < 6; i++) {
+        int row = i / 2;
+        float sign = (i % 2 == 0) ? 1.0f : -1.0f;
+        Plane& p = planes[i];
+        p.a = pm.at(3, 0) + sign*pm.at(row, 0);
+        p.b = pm.at(3, 1) + sign*pm.at(row, 1);
+        p.c = pm.at(3, 2) + sign*pm.at(row, 2);
+        p.d = pm.at(3, 3) + sign*pm.at(row, 3);
+    }
+}
+
+bool Frustum::intersectsBox(const Vector3& min, const Vector3& max) const {
+    // for every plane only test the corner of the box that lies
+    // furthest along the plane normal. if even that corner is
+    // behind the plane the whole box is outside of the frustum.
+    // this is conservative: some boxes near the frustum corners
+    // are reported as visible even though they are not.
+    for (int i = 0; i < 6; i++) {
+        const Plane& p = planes[i];
+        float x = p.a >= 0 ? max.x : min.x;
+        float y = p.b >= 0 ? max.y : min.y;
+        float z = p.c >= 0 ? max.z : min.z;
+        if (p.a*x + p.b*y + p.c*z + p.d < 0) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,63 @@
+/*  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
+
+ > Matrix and view frustum helpers used to cull parts of the LED lattice
+ > that are outside of the current view.
+
+ > Copyright (C) 2014 by Daniel Intskirveli, Gurpreet Singh, Christopher Zhang.
+
+ > frustum.h - 4x4 matrices and frustum/bounding box intersection tests.
+
+ > Written by: Daniel Intskirveli, Gurpreet Singh, Christopher Zhang, 2014.
+
+  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_ */
+
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+struct Vector3 {
+    float x, y, z;
+};
+
+//! 4x4 matrix
+/*!
+    Column-major like OpenGL, so data() can be handed straight to
+    glLoadMatrixf() / glMultMatrixf().
+*/
+class Matrix4
+{
+public:
+    Matrix4();
+
+    static Matrix4 frustum(float left, float right, float bottom, float top, float zNear, float zFar);
+    static Matrix4 translation(float x, float y, float z);
+    static Matrix4 rotation(float angle, float x, float y, float z);
+
+    Matrix4 operator*(const Matrix4& other) const;
+    Vector3 transform(const Vector3& v) const;     // transforms a point (w = 1)
+
+    const float* data() const { return m; }
+    float at(int row, int col) const { return m[col*4 + row]; }
+
+private:
+    float m[16];
+};
+
+//! View frustum
+/*!
+    Six planes extracted from a combined projection * modelview matrix.
+    Used to test axis aligned boxes (in object space) for visibility.
+*/
+class Frustum
+{
+public:
+    void set(const Matrix4& projectionModelview);
+    bool intersectsBox(const Vector3& min, const Vector3& max) const;
+
+private:
+    struct Plane {
+        float a, b, c, d;
+    };
+    Plane planes[6];
+};
+
+#endif
@@ -0,0 +1,156 @@
+/*  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
+
+ > Lattice helpers: the size of the LED lattice, its split into bricks
+ > for culling, and turning LED states into points or cubes to draw.
+
+ > Copyright (C) 2014 by Daniel Intskirveli, Gurpreet Singh, Christopher Zhang.
+
+ > lattice.cpp - cpu side of drawing the LED lattice, no OpenGL calls.
+
+ > Written by: Daniel Intskirveli, Gurpreet Singh, Christopher Zhang, 2014.
+
+  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_ */
+
+#include "lattice.h"
+#include <algorithm>
+
+void LatticeGeometry::calculate() {
+    // if cubes are being drawn then delta is
+    // spacing + cube size else, if points then
+    // delta is spacing because points don't have area.
+    // the number of cubes in each direction is multiplied by
+    // delta and subtracted by spacing because the last cube doesn't
+    // need to include spacing in each direction.
+    delta = spacing + (points ? 0 : ledSize);
+    xSize = xCubes*delta - spacing;
+    ySize = yCubes*delta - spacing;
+    zSize = zCubes*delta - spacing;
+}
+
+void buildBricks(const LatticeGeometry& g, std::vector<Brick>& bricks) {
+    // split the lattice into blocks of BRICK_SIZE LEDs in each
+    // direction. every brick gets a bounding box in the same space
+    // the LEDs are translated to in paintGL(), padded by the spacing
+    // so that points (which have a size in pixels, not in object
+    // space) on the edge of a brick don't get culled too early.
+    bricks.clear();
+    float d = g.delta;
+    for (int x = 0; x < g.xCubes; x += BRICK_SIZE) {
+        for (int y = 0; y < g.yCubes; y += BRICK_SIZE) {
+            for (int z = 0; z < g.zCubes; z += BRICK_SIZE) {
+                Brick b;
+                b.x0 = x;
+                b.y0 = y;
+                b.z0 = z;
+                b.x1 = std::min(x + (int) BRICK_SIZE, g.xCubes);
+                b.y1 = std::min(y + (int) BRICK_SIZE, g.yCubes);
+                b.z1 = std::min(z + (int) BRICK_SIZE, g.zCubes);
+                b.min.x = b.x0*d - g.xSize/2 - g.spacing;
+                b.min.y = b.y0*d - g.ySize/2 - g.spacing;
+                b.min.z = b.z0*d - g.zSize/2 - g.spacing;
+                b.max.x = (b.x1 - 1)*d - g.xSize/2 + g.ledSize + g.spacing;
+                b.max.y = (b.y1 - 1)*d - g.ySize/2 + g.ledSize + g.spacing;
+                b.max.z = (b.z1 - 1)*d - g.zSize/2 + g.ledSize + g.spacing;
+                bricks.push_back(b);
+            }
+        }
+    }
+}
+
+void LatticeState::resize(const LatticeGeometry& g) {
+    voxels.resize(g.xCubes, g.yCubes, g.zCubes, MAX_LOD_LEVEL + 1);
+    intensity.resize(g.xCubes, g.yCubes, g.zCubes);
+    version = -1;
+}
+
+void LatticeState::build(const LatticeGeometry& g, const std::vector<Brick>& bricks, const std::vector<char>& needed,
+                         int level, float transparency, bool drawOff) {
+    // level 0 of the voxels has to be filled in for the needed bricks.
+    // updates the coarse levels of those bricks and turns them into
+    // points or cubes on the chosen level of detail. the vertices of a
+    // brick are kept together so that cubes of the wall can skip bricks
+    // that are outside of the view without touching the others.
+    const VoxelGrid& cells = voxels.level(level);
+    int step = 1 << level;
+
+    // brightness to alpha for all 256 values at once instead of for every LED
+    unsigned char alpha[256];
+    for (int v = 0; v < 256; v++) {
+        alpha[v] = (unsigned char) (255*(transparency + (1 - transparency)*v/255.0f));
+    }
+    float d = g.delta;
+    int count = bricks.size();
+
+    // the vectors keep their memory, so after the first
+    // frame this doesn't allocate anything
+    vertices.clear();
+    colors.clear();
+    brickFirst.assign(count, 0);
+    brickCount.assign(count, 0);
+
+    for (int b = 0; b < count; b++) {
+        if (!needed[b]) {
+            continue;
+        }
+        const Brick& brick = bricks[b];
+        voxels.update(brick.x0, brick.y0, brick.z0, brick.x1, brick.y1, brick.z1, level);
+
+        brickFirst[b] = vertices.size() / 3;
+        for (int i = brick.x0/step; i < (brick.x1 + step - 1)/step; i++) {
+            for (int j = brick.y0/step; j < (brick.y1 + step - 1)/step; j++) {
+                for (int k = brick.z0/step; k < (brick.z1 + step - 1)/step; k++) {
+                    // on a coarse level the value is the average
+                    // brightness of all the LEDs in the cell
+                    unsigned char value = cells.value(i, j, k);
+                    bool on = value > 0;
+                    if (!on && !(drawOff && transparency)) {
+                        continue;
+                    }
+                    unsigned char color[4] = { 255, 255, 255, alpha[value] };
+
+                    // number of LEDs the cell covers in each direction,
+                    // less than step for cells on the far edges
+                    int nx = std::min(step, g.xCubes - i*step);
+                    int ny = std::min(step, g.yCubes - j*step);
+                    int nz = std::min(step, g.zCubes - k*step);
+                    float x = i*step*d - g.xSize/2;
+                    float y = j*step*d - g.ySize/2;
+                    float z = k*step*d - g.zSize/2;
+
+                    if (g.points) {
+                        // a point in the middle of the cell
+                        addPoint(x + (nx - 1)*d/2, y + (ny - 1)*d/2, z + (nz - 1)*d/2, color);
+                    } else {
+                        // one cube spanning all the LEDs in the cell
+                        addCube(x, y, z, (nx - 1)*d + g.ledSize, (ny - 1)*d + g.ledSize, (nz - 1)*d + g.ledSize, color);
+                    }
+                }
+            }
+        }
+        brickCount[b] = vertices.size() / 3 - brickFirst[b];
+    }
+}
+
+// add a cube with its corner at x, y, z to the vertex arrays
+void LatticeState::addCube(float x, float y, float z, float xSize, float ySize, float zSize, const unsigned char* color) {
+    // the quads of the cube, as offsets from its corner
+    static const float corners[24][3] = {
+        {1, 1, 0}, {0, 1, 0}, {0, 1, 1}, {1, 1, 1},
+        {1, 0, 1}, {0, 0, 1}, {0, 0, 0}, {1, 0, 0},
+        {1, 1, 1}, {0, 1, 1}, {0, 0, 1}, {1, 0, 1},
+        {1, 0, 0}, {0, 0, 0}, {0, 1, 0}, {1, 1, 0},
+        {0, 1, 1}, {0, 1, 0}, {0, 0, 0}, {0, 0, 1},
+        {1, 1, 0}, {1, 1, 1}, {1, 0, 1}, {1, 0, 0}
+    };
+    for (int v = 0; v < 24; v++) {
+        addPoint(x + corners[v][0]*xSize, y + corners[v][1]*ySize, z + corners[v][2]*zSize, color);
+    }
+}
+
+// add a point to the vertex arrays
+void LatticeState::addPoint(float x, float y, float z, const unsigned char* color) {
+    vertices.push_back(x);
+    vertices.push_back(y);
+    vertices.push_back(z);
+    colors.insert(colors.end(), color, color + 4);
+}
@@ -0,0 +1,68 @@
+/*  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
+
+ > Lattice helpers: the size of the LED lattice, its split into bricks
+ > for culling, and turning LED states into points or cubes to draw.
+
+ > Copyright (C) 2014 by Daniel Intskirveli, Gurpreet Singh, Christopher Zhang.
+
+ > lattice.h - cpu side of drawing the LED lattice, no OpenGL calls.
+
+ > Written by: Daniel Intskirveli, Gurpreet Singh, Christopher Zhang, 2014.
+
+  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_ */
+
+#ifndef LATTICE_H
+#define LATTICE_H
+
+#include <vector>
+#include "frustum.h"
+#include "voxelgrid.h"
+
+enum { MAX_LOD_LEVEL = 4 };                                 // coarsest level of detail, 16x16x16 LEDs per cell
+enum { BRICK_SIZE = 1 << MAX_LOD_LEVEL };                   // so that no coarse cell spans two bricks
+
+//! Number, size and spacing of the LEDs
+struct LatticeGeometry {
+    int xCubes;
+    int yCubes;
+    int zCubes;
+    float ledSize;
+    float spacing;
+    bool points;                                            // points have no area, so only spacing is between them
+
+    float delta;                                            // distance from one LED to the next
+    float xSize;                                            // size of the whole cube in each direction
+    float ySize;
+    float zSize;
+
+    void calculate();                                       // delta and the sizes from the rest
+};
+
+//! Block of BRICK_SIZE^3 LEDs with its bounding box, used for culling
+struct Brick {
+    int x0, y0, z0;                                         // first LED in the brick
+    int x1, y1, z1;                                         // one past the last LED
+    Vector3 min, max;                                       // bounding box in object space
+};
+
+void buildBricks(const LatticeGeometry& geometry, std::vector<Brick>& bricks);
+
+//! LED state and geometry shared by all cubes of the wall showing the same thing
+struct LatticeState {
+    VoxelPyramid voxels;                                    // state of the LEDs, level 0 is the full cube
+    VoxelGrid intensity;                                    // what the layers turned on, before the LedDriver
+    std::vector<float> vertices;                            // x, y, z of every point / cube corner
+    std::vector<unsigned char> colors;                      // r, g, b, a of every vertex
+    std::vector<int> brickFirst;                            // first vertex of every brick
+    std::vector<int> brickCount;                            // number of vertices of every brick
+    int version;                                            // Compositor::version() the LEDs were drawn with
+
+    LatticeState() : version(-1) {}
+    void resize(const LatticeGeometry& geometry);
+    void build(const LatticeGeometry& geometry, const std::vector<Brick>& bricks, const std::vector<char>& needed,
+               int level, float transparency, bool drawOff);
+    void addCube(float x, float y, float z, float xSize, float ySize, float zSize, const unsigned char* color);
+    void addPoint(float x, float y, float z, const unsigned char* color);
+};
+
+#endif
@@ -0,0 +1,78 @@
+/*  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
+
+ > The built in animation layers: all LEDs on, the wave, and a point
+ > cloud such as the face.
+
+ > Copyright (C) 2014 by Daniel Intskirveli, Gurpreet Singh, Christopher Zhang.
+
+ > layers.cpp - layers for the Compositor.
+
+ > Written by: Daniel Intskirveli, Gurpreet Singh, Christopher Zhang, 2014.
+
+  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_ */
+
+#include "layers.h"
+#include "animations.h"
+#include <algorithm>
+
+void AllOnLayer::render(BitPlane& plane, int) {
+    plane.fill(true);
+}
+
+void WaveLayer::render(BitPlane& plane, int t) {
+    // same LEDs as waveIsOn(), but instead of asking every LED
+    // whether it is on, the height is worked out once per column
+    if (plane.width() == 1 && plane.height() == 1 && plane.depth() == 1) {
+        plane.fill(true);
+        return;
+    }
+    for (int x = 0; x < plane.width(); x++) {
+        for (int z = 0; z < plane.depth(); z++) {
+            int y = waveHeight(x, z, t, plane.height());
+            if (y >= 0 && y < plane.height()) {
+                plane.set(x, y, z);
+            }
+        }
+    }
+}
+
+void GradientLayer::renderBrightness(VoxelGrid& grid, int) {
+    // every x is one plane of LEDs with the same brightness
+    int plane = grid.height()*grid.depth();
+    for (int x = 0; x < grid.width(); x++) {
+        unsigned char value = (unsigned char) (255*(x + 1) / grid.width());
+        std::fill(grid.data() + x*plane, grid.data() + (x + 1)*plane, value);
+    }
+}
+
+void PointCloudLayer::resize(int width, int height, int depth) {
+    w = width;
+    h = height;
+    d = depth;
+    normalized = points;
+    normalizePoints(normalized, w, h, d);
+}
+
+void PointCloudLayer::setPoints(const std::vector<Vector3>& newPoints) {
+    points = newPoints;
+    resize(w, h, d);
+}
+
+void PointCloudLayer::render(BitPlane& plane, int) {
+    rasterizePoints(plane, normalized);
+}
+
+void rasterizePoints(BitPlane& plane, const std::vector<Vector3>& points) {
+    // the same LEDs pointsAreOn() finds, but one pass over the points
+    // instead of a pass over the points for every LED
+    // (points that didn't get scaled because all of them have the
+    // same x, y or z are NaN, and fail the range check as well)
+    int w = plane.width();
+    int h = plane.height();
+    int d = plane.depth();
+    for (std::vector<Vector3>::const_iterator it = points.begin(); it != points.end(); ++it) {
+        if (it->x >= 0 && it->x < w && it->y >= 0 && it->y < h && it->z >= 0 && it->z < d) {
+            plane.set((int) it->x, (int) it->y, (int) it->z);
+        }
+    }
+}
@@ -0,0 +1,69 @@
+/*  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
+
+ > The built in animation layers: all LEDs on, the wave, and a point
+ > cloud such as the face.
+
+ > Copyright (C) 2014 by Daniel Intskirveli, Gurpreet Singh, Christopher Zhang.
+
+ > layers.h - layers for the Compositor.
+
+ > Written by: Daniel Intskirveli, Gurpreet Singh, Christopher Zhang, 2014.
+
+  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_ */
+
+#ifndef LAYERS_H
+#define LAYERS_H
+
+#include "compositor.h"
+#include "frustum.h"
+
+//! Every LED on, what "No Animation" used to show
+class AllOnLayer : public Layer
+{
+public:
+    std::string name() const { return "All LEDs On"; }
+    void render(BitPlane& plane, int t);
+};
+
+//! The sine wave of waveIsOn(), one LED per x, z column
+class WaveLayer : public Layer
+{
+public:
+    std::string name() const { return "Wave Animation"; }
+    bool isAnimated() const { return true; }
+    void render(BitPlane& plane, int t);
+};
+
+//! Brightness going up from 0 to 255 along x, to preview grayscale
+class GradientLayer : public Layer
+{
+public:
+    std::string name() const { return "Brightness Gradient"; }
+    bool hasBrightness() const { return true; }
+    void renderBrightness(VoxelGrid& grid, int t);
+};
+
+//! Points scaled to fit the cube, such as the face
+class PointCloudLayer : public Layer
+{
+public:
+    PointCloudLayer(const std::string& name) : layerName(name), w(0), h(0), d(0) {}
+
+    std::string name() const { return layerName; }
+    void resize(int width, int height, int depth);
+    void render(BitPlane& plane, int t);
+
+    // the points as they were loaded, they are scaled on every resize
+    void setPoints(const std::vector<Vector3>& points);
+
+private:
+    std::string layerName;
+    std::vector<Vector3> points;
+    std::vector<Vector3> normalized;
+    int w, h, d;
+};
+
+// turns on the LEDs at the (normalized) points
+void rasterizePoints(BitPlane& plane, const std::vector<Vector3>& points);
+
+#endif
@@ -0,0 +1,90 @@
+/*  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
+
+ > Interface for animation plugins. Plain C so that plugins can be built
+ > with any compiler, and don't need Qt or the rest of the simulation.
+
+ > Copyright (C) 2014 by Daniel Intskirveli, Gurpreet Singh, Christopher Zhang.
+
+ > ledcube_plugin.h - the ABI between LEDcube and its plugins.
+
+ > Written by: Daniel Intskirveli, Gurpreet Singh, Christopher Zhang, 2014.
+
+  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_ */
+
+#ifndef LEDCUBE_PLUGIN_H
+#define LEDCUBE_PLUGIN_H
+
+/*
+    A plugin is a shared library in the plugin directory (plugins/ next
+    to the executable, or the "pluginDirectory" setting) that exports
+
+        const LEDcubePlugin* ledcube_plugin(void);
+
+    The returned struct has to stay valid until the library is unloaded.
+    Every plugin shows up as a layer in the "3D Animations" group.
+
+    The structs only ever grow at the end, and apiVersion goes up when
+    they do. A plugin built against an older version keeps working, a
+    plugin that needs a newer version than the app has is skipped.
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LEDCUBE_PLUGIN_API_VERSION 1
+#define LEDCUBE_PLUGIN_ENTRY "ledcube_plugin"
+
+#if defined(_WIN32)
+#define LEDCUBE_PLUGIN_EXPORT __declspec(dllexport)
+#else
+#define LEDCUBE_PLUGIN_EXPORT __attribute__((visibility("default")))
+#endif
+
+enum {
+    LEDCUBE_PLUGIN_ANIMATED = 1                             /* frames depend on the time */
+};
+
+/* one frame for the plugin to fill in */
+typedef struct LEDcubeFrame {
+    int width;                                              /* LEDs along x, y and z */
+    int height;
+    int depth;
+    int t;                                                  /* time in milliseconds */
+
+    /* width*height*depth brightness values, 0 is off and 255 fully on.
+       LED x, y, z is leds[(x*height + y)*depth + z], so z is the inner
+       loop. all 0 when render() is called. */
+    unsigned char* leds;
+
+    const float* parameters;                                /* one value per LEDcubePlugin parameter */
+    int parameterCount;
+} LEDcubeFrame;
+
+typedef struct LEDcubePlugin {
+    int apiVersion;                                         /* LEDCUBE_PLUGIN_API_VERSION the plugin was built with */
+    const char* name;                                       /* shown next to the layer checkbox */
+    int flags;                                              /* LEDCUBE_PLUGIN_ANIMATED */
+
+    /* parameters the plugin takes, the app reads their values from its
+       settings ("plugins/<name>/<parameter>") and passes them to render() */
+    int parameterCount;
+    const char* const* parameterNames;
+    const float* parameterDefaults;
+
+    /* optional, called whenever the size of the cube changes. whatever it
+       returns is passed to render() and destroy(), for lookup tables etc. */
+    void* (*create)(int width, int height, int depth);
+    void (*destroy)(void* state);
+
+    /* fills in the whole frame at once */
+    void (*render)(void* state, LEDcubeFrame* frame);
+} LEDcubePlugin;
+
+typedef const LEDcubePlugin* (*LEDcubePluginEntry)(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,12 +1,92 @@
 #include <QApplication>
 #include <QDesktopWidget>
+#include <iostream>
 #include "matrixwidget.h"
 
 #include "window.h"
 
+// reads "--export <path>" and the options that go with it, returns
+// false if there is no export on the command line. error is set if a
+// value is missing or out of range
+static bool parseExportArguments(const QStringList& args, ExportSettings& settings, QString& animation,
+                                 QString& error) {
+    // options that take a value, anything else is a flag of its own
+    static const char* const valueOptions[] = {
+        "--export", "--format", "--frames", "--fps", "--speed", "--size", "--threads", "--animation", "--audio"
+    };
+    bool exporting = false;
+    for (int i = 1; i < args.count(); i++) {
+        QString option = args.at(i);
+        bool takesValue = false;
+        for (size_t n = 0; n < sizeof(valueOptions)/sizeof(valueOptions[0]); n++) {
+            takesValue = takesValue || option == valueOptions[n];
+        }
+        if (!takesValue) {
+            continue;
+        }
+        if (i + 1 >= args.count()) {
+            error = option + " needs a value";
+            return exporting;
+        }
+        QString value = args.at(++i);
+        if (option == "--export") {
+            exporting = true;
+            settings.path = value;
+            if (value.endsWith(".y4m", Qt::CaseInsensitive)) {
+                settings.format = ExportSettings::FORMAT_Y4M;
+            }
+        } else if (option == "--format") {
+            settings.format = (value == "y4m") ? ExportSettings::FORMAT_Y4M : ExportSettings::FORMAT_PNG;
+        } else if (option == "--frames") {
+            settings.frames = value.toInt();
+        } else if (option == "--fps") {
+            settings.fps = value.toDouble();
+        } else if (option == "--speed") {
+            settings.speed = value.toDouble();
+        } else if (option == "--size") {
+            QStringList size = value.split("x");
+            if (size.count() != 2) {
+                error = "--size has to be WxH";
+                return exporting;
+            }
+            settings.width = size.at(0).toInt();
+            settings.height = size.at(1).toInt();
+        } else if (option == "--threads") {
+            settings.threads = value.toInt();
+        } else if (option == "--animation") {
+            animation = value;
+        }
+    }
+
+    if (!exporting) {
+        return false;
+    }
+    // written as !(x > 0) so that nan is caught too
+    if (!(settings.frames > 0)) {
+        error = "--frames has to be at least 1";
+    } else if (!(settings.fps > 0)) {
+        error = "--fps has to be more than 0";
+    } else if (!(settings.speed > 0)) {
+        error = "--speed has to be more than 0";
+    } else if (!(settings.width > 0) || !(settings.height > 0)) {
+        error = "--size has to be at least 1x1";
+    }
+    return exporting;
+}
+
 //! Entry point for the app
 /*!
-    Creates the window and shows it.
+    Creates the window and shows it. With --export it renders the
+    animation to disk instead and quits:
+
+    LEDcube --export <dir or file.y4m> [--format png|y4m] [--frames N] [--fps F]
+            [--speed S] [--size WxH] [--threads N] [--animation none|wave|face|gradient|NAME]
+
+    where NAME is the name of a plugin layer.
+
+    LEDcube --audio <file.wav or ->
+
+    shows the spectrum of a WAV file, or of what comes in on stdin.
 */
 int main(int argc, char *argv[])
 {
@@ -14,5 +94,36 @@ int main(int argc, char *argv[])
     Window window;
     window.resize(window.sizeHint());
     window.show();
+
+    QStringList args = app.arguments();
+    int audio = args.indexOf("--audio");
+    if (audio > 0 && audio + 1 < args.count() && !window.openAudio(args.at(audio + 1))) {
+        std::cerr << "can't open audio " << args.at(audio + 1).toLocal8Bit().constData() << std::endl;
+        return 1;
+    }
+
+    ExportSettings settings;
+    QString animation;
+    QString error;
+    bool exporting = parseExportArguments(args, settings, animation, error);
+    if (!error.isEmpty()) {
+        std::cerr << error.toLocal8Bit().constData() << std::endl;
+        return 1;
+    }
+    if (exporting) {
+        if (!animation.isEmpty() && !window.setAnimation(animation)) {
+            std::cerr << "unknown animation " << animation.toLocal8Bit().constData() << std::endl;
+            return 1;
+        }
+        QTime timer;
+        timer.start();
+        if (!window.exportAnimation(settings, &error)) {
+            std::cerr << "export failed: " << error.toLocal8Bit().constData() << std::endl;
+            return 1;
+        }
+        std::cout << "exported " << settings.frames << " frames in "
+                  << timer.elapsed() / 1000.0 << " s" << std::endl;
+        return 0;
+    }
     return app.exec();
 }
@@ -13,6 +13,8 @@
   -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_ */
 
 #include "matrixwidget.h"
+#include "animations.h"
+#include "plugins.h"
 #include <QtOpenGL>
 #include <cmath>
 #include <QTimer>
@@ -29,6 +31,21 @@ MatrixWidget::MatrixWidget(QWidget *parent) : QGLWidget(parent) {
     rawZoom = 0;
     setZoom(rawZoom);
     DRAW_OFF_LEDS_AS_TRANSLUSCENT = false;
+    levelOfDetail = settings->value("levelOfDetail", true).toBool();
+    volumeRendering = settings->value("volumeRendering", false).toBool();
+    viewportHeight = 1;
+    wallColumns = std::max(1, settings->value("wallColumns", 1).toInt());
+    wallRows = std::max(1, settings->value("wallRows", 1).toInt());
+    wallGap = settings->value("wallGap", 2).toInt();
+    wallPhase = settings->value("wallPhase", 0).toInt();
+
+    DriverSettings driverSettings;
+    driverSettings.mode = settings->value("driverMode", DriverSettings::MODE_OFF).toInt();
+    driverSettings.bits = settings->value("driverBits", 8).toInt();
+    driverSettings.refreshRate = settings->value("driverRefreshRate", 120).toInt();
+    driverSettings.exposure = settings->value("driverExposure", 16).toInt();
+    driverSettings.multiplex = settings->value("driverMultiplex", true).toBool();
+    driver.setSettings(driverSettings);
     
     xCubes = settings->value("xSize", 20).toInt();
     yCubes = settings->value("ySize", 20).toInt();
@@ -40,11 +57,31 @@ MatrixWidget::MatrixWidget(QWidget *parent) : QGLWidget(parent) {
     setYRotation(45);
     setZRotation(0);
 
-    faceAnimation = false;
-    waveAnimation = false;
-    noAnimation = true;
-
-    Vertices = new std::vector<Vector3>;
+    // the layers have to be in the order of the LAYER_ enum.
+    // all LEDs on is what the cube shows before anything is picked
+    faceLayer = new PointCloudLayer("Draw Face");
+    compositor.addLayer(new AllOnLayer);
+    compositor.addLayer(new WaveLayer);
+    compositor.addLayer(faceLayer);
+    compositor.addLayer(new GradientLayer);
+    sequenceLayer = new SequenceLayer;
+    sequenceLayer->setFps(settings->value("sequenceFps", 30).toInt());
+    compositor.addLayer(sequenceLayer);
+    meshLayer = new MeshLayer;
+    meshLayer->setSolid(settings->value("meshSolid", false).toBool());
+    compositor.addLayer(meshLayer);
+    automatonLayer = new AutomatonLayer;
+    automatonLayer->setRule(settings->value("automatonRule", "B6/S5-7").toString().toStdString());
+    automatonLayer->setWrap(settings->value("automatonWrap", true).toBool());
+    automatonLayer->setSpeed(settings->value("automatonSpeed", 10).toInt());
+    compositor.addLayer(automatonLayer);
+    compositor.addLayer(new ParticleLayer(ParticleLayer::EFFECT_RAIN));
+    compositor.addLayer(new ParticleLayer(ParticleLayer::EFFECT_SNOW));
+    compositor.addLayer(new ParticleLayer(ParticleLayer::EFFECT_FIREWORKS));
+    audioLayer = new AudioLayer;
+    compositor.addLayer(audioLayer);
+    loadPluginLayers();
+    compositor.setEnabled(LAYER_ALL_ON, true);
 
     // set up timer to call updateGL() fps times a second
     // if I recall correctly updateGL() should be a no-op
@@ -83,6 +120,9 @@ void MatrixWidget::initializeGL() {
     glEnable(GL_POLYGON_SMOOTH);
 
     glMatrixMode(GL_MODELVIEW);
+
+    // without shaders or 3D textures the vertex arrays are used either way
+    volume.initialize();
 }
 
 // untility function to find the maximum of three numbers
@@ -104,41 +144,126 @@ float MatrixWidget::delta() {
 }
 
 void MatrixWidget::calcCubeSize() {
-    // cube size in each direction is calculated using the delta()
-    // function. the number of cubes in each direction is multiplied by
-    // delta and subtracted by spacing because the last cube doesn't
-    // need to include spacing in each direction.
+    // cube size in each direction is calculated by the lattice
+    // geometry, the same way delta() does it.
     // take the maximum of the cubes in each direction
     // because we don't want the widget to be clipping in the viewport.
-    xCubeSize = xCubes*delta() - spacing;
-    yCubeSize = yCubes*delta() - spacing;
-    zCubeSize = zCubes*delta() - spacing;
-    maxCube = maximum(xCubeSize, yCubeSize, zCubeSize);
+    // when a wall of several cubes is shown, it has to fit instead.
+    geometry.xCubes = xCubes;
+    geometry.yCubes = yCubes;
+    geometry.zCubes = zCubes;
+    geometry.ledSize = ledSize;
+    geometry.spacing = spacing;
+    geometry.points = (mode == MODE_POINTS);
+    geometry.calculate();
+    xCubeSize = geometry.xSize;
+    yCubeSize = geometry.ySize;
+    zCubeSize = geometry.zSize;
+    float xWallSize = wallColumns*xCubeSize + (wallColumns - 1)*wallGap*delta();
+    float yWallSize = wallRows*yCubeSize + (wallRows - 1)*wallGap*delta();
+    maxCube = maximum(xWallSize, yWallSize, zCubeSize);
+    buildBricks(geometry, bricks);
+    resizeStates(states.size());
+    compositor.resize(xCubes, yCubes, zCubes);
 }
 
-bool MatrixWidget::isOn(int x, int y, int z, int t) {
-    if (false) return true;
+Vector3 MatrixWidget::instanceOffset(int n) {
+    // cubes of the wall are numbered row by row, the
+    // wall as a whole is centered around the origin
+    int column = n % wallColumns;
+    int row = n / wallColumns;
+    Vector3 offset;
+    offset.x = (column - (wallColumns - 1)/2.0f) * (xCubeSize + wallGap*delta());
+    offset.y = (row - (wallRows - 1)/2.0f) * (yCubeSize + wallGap*delta());
+    offset.z = 0;
+    return offset;
+}
 
-    if (waveAnimation) {
-        if (xCubes == 1 && yCubes == 1 && zCubes == 1) {
-            return true;
-        }
-        if(y == round(sin(z/2 + t/100)*2)+ round(sin(x/2)*2) + yCubes/2) {
-            return true;
-        }
-    } else if (faceAnimation) {
-        // iterate the vector
-        for (std::vector<Vector3>::iterator it = Vertices->begin() ; it != Vertices->end(); ++it) {
-            Vector3 a = *it;
-            if (a.x == x && a.y == y && a.z == z)   // verify if the coordinate is in the vector
-                return true;
+bool MatrixWidget::isAnimated() {
+    // whether the LED states depend on the time. the
+    // driver flickers differently from frame to frame
+    return compositor.isAnimated() || driver.isEnabled();
+}
+
+void MatrixWidget::resizeStates(int count) {
+    states.resize(count);
+    for (int s = 0; s < count; s++) {
+        states[s].resize(geometry);
+    }
+}
+
+float MatrixWidget::pixelsPerLed(float a) {
+    // the frustum set up in resizeGL() is a*zoom high at the near
+    // plane (3a away), the center of the cube is 4a away from the
+    // camera. so that's how much of the cube the viewport shows.
+    float visibleHeight = a * zoom * 4 / 3;
+    if (visibleHeight <= 0) {
+        return 0;
+    }
+    return delta() * viewportHeight / visibleHeight;
+}
+
+int MatrixWidget::lodLevel(float pixels) {
+    // pick the finest level on which a cell still covers a couple of
+    // pixels. every level doubles the size of a cell, and a cell that
+    // covers less than a pixel is just wasted work.
+    if (!levelOfDetail || pixels <= 0) {
+        return 0;
+    }
+    int level = 0;
+    while (level < MAX_LOD_LEVEL && pixels * (1 << level) < LOD_MIN_PIXELS) {
+        level++;
+    }
+    return level;
+}
+
+bool MatrixWidget::updateLeds(int s, int t) {
+    // the layers draw the whole cube at once, that's only needed when
+    // something changed or the animation moves. the driver turns that
+    // into what is seen during the frame. false if the LEDs are the
+    // same as last time.
+    LatticeState& state = states[s];
+    VoxelGrid& leds = state.voxels.level(0);
+    bool changed = false;
+    if (compositor.isAnimated() || state.version != compositor.version()) {
+        compositor.compose(driver.isEnabled() ? state.intensity : leds, t);
+        state.version = compositor.version();
+        changed = true;
+    }
+    if (driver.isEnabled()) {
+        driver.apply(state.intensity, leds, t);
+        changed = true;
+    }
+    return changed;
+}
+
+void MatrixWidget::updateState(int s, int level, int t) {
+    // the state turns every brick that is visible in at least one of
+    // the cubes showing it into points or cubes on the chosen level
+    // of detail.
+    LatticeState& state = states[s];
+    updateLeds(s, t);
+
+    int instances = wallColumns*wallRows;
+    int brickCount = bricks.size();
+    brickNeeded.assign(brickCount, 0);
+    for (int b = 0; b < brickCount; b++) {
+        for (int n = 0; n < instances && !brickNeeded[b]; n++) {
+            if (states.size() == 1 || n == s) {
+                brickNeeded[b] = brickVisible[n*brickCount + b];
+            }
         }
     }
 
-    return false;
+    state.build(geometry, bricks, brickNeeded, level, transparency, DRAW_OFF_LEDS_AS_TRANSLUSCENT);
 }
 
 void MatrixWidget::paintGL() {
+    renderFrame(getMilliCount());
+}
+
+// draws the cube as it looks t milliseconds into the animation
+void MatrixWidget::renderFrame(int t) {
     // Clear the buffer, clear the matrix 
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glLoadIdentity();
@@ -150,60 +275,166 @@ void MatrixWidget::paintGL() {
     // also calculating a similar value in resizeGL()
     float a = (((float) maxCube) * sqrt((float) 3)); 
 
-    // multiplies the current matrix by a translation matrix.
-    glTranslatef(0, 0, -4*a);
+    // multiplies the current matrix by a translation matrix,
+    // then allow rotation on the X, Y and Z axis. the matrix is
+    // built on the cpu as well so that we can cull against it.
+    Matrix4 modelview = Matrix4::translation(0, 0, -4*a)
+                      * Matrix4::rotation(xRot, 1.0f, 0.0f, 0.0f)
+                      * Matrix4::rotation(yRot, 0.0f, 1.0f, 0.0f)
+                      * Matrix4::rotation(zRot, 0.0f, 0.0f, 1.0f);
+    glLoadMatrixf(modelview.data());
+
+    // level of detail: when a LED covers less than a couple of pixels
+    // draw cells of 2^level LEDs in each direction instead, so the work
+    // per frame depends on the size of the viewport, not on the cube.
+    float pixels = pixelsPerLed(a);
+    int level = lodLevel(pixels);
+    int step = 1 << level;
+
+    /* The cubes are drawn brick by brick, for every cube of the wall.
+    Bricks whose bounding box is outside of the view frustum are skipped 
+    entirely, so when zoomed into a corner of a large cube only the 
+    visible part gets traversed. Cubes of the wall that show the same 
+    thing (all of them, unless the animation is shifted in time from 
+    one cube to the next) share one state: its LEDs are evaluated and 
+    turned into vertices once, and then drawn at the offset of every
+    cube. 
+    */
+
+    int instances = wallColumns*wallRows;
+    int stateCount = (isAnimated() && wallPhase != 0) ? instances : 1;
+    if ((int) states.size() != stateCount) {
+        resizeStates(stateCount);
+    }
+
+    // the LEDs can also stay on the GPU, in a 3D texture per state. only
+    // the bricks that changed get uploaded, and a fragment shader finds
+    // the LEDs along the ray of every pixel, so nothing here depends on
+    // the number of LEDs. it doesn't need the level of detail either.
+    if (volumeRendering && volume.fits(xCubes, yCubes, zCubes)) {
+        volume.resize(stateCount);
+        for (int s = 0; s < stateCount; s++) {
+            if (updateLeds(s, t + s*wallPhase) || !volume.isCurrent(s)) {
+                volume.update(s, states[s].voxels.level(0), bricks);
+            }
+        }
+        for (int n = 0; n < instances; n++) {
+            Vector3 offset = instanceOffset(n);
+            glPushMatrix();
+            glTranslatef(offset.x, offset.y, offset.z);
+            volume.draw(stateCount == 1 ? 0 : n, geometry, transparency, DRAW_OFF_LEDS_AS_TRANSLUSCENT);
+            glPopMatrix();
+        }
+        return;
+    }
 
-    // allow rotation on the X, Y and Z axis
-    glRotatef(xRot,1.0f,0.0f,0.0f);
-    glRotatef(yRot,0.0f,1.0f,0.0f);
-    glRotatef(zRot,0.0f,0.0f,1.0f);
+    int brickCount = bricks.size();
+    brickVisible.resize(instances*brickCount);
+    for (int n = 0; n < instances; n++) {
+        Vector3 offset = instanceOffset(n);
+        Frustum frustum;
+        frustum.set(projection * modelview * Matrix4::translation(offset.x, offset.y, offset.z));
+        for (int b = 0; b < brickCount; b++) {
+            brickVisible[n*brickCount + b] = frustum.intersectsBox(bricks[b].min, bricks[b].max);
+        }
+    }
 
-    bool on;
-    int t = getMilliCount();
+    for (int s = 0; s < stateCount; s++) {
+        updateState(s, level, t + s*wallPhase);
+    }
 
     // check if points are selected
+    GLenum primitive = GL_QUADS;
     if (mode == MODE_POINTS) {
-        glPointSize(spacing*10);
-    }
-
-    /* The cubes are drawn using the loops below. The loops run until all 
-    the cubes specified by the user, xCubes, yCubes, and zCubes are not 
-    drawn. Inside the third loop, the glPushMatrix() set where to start 
-    the current object transformations. Then glTranslatef multiplies 
-    the currect matrix by the translation matrix, basically where we want 
-    the next cube to be drawn. Then we check what type of drawing the 
-    user selected, then we check is the cube is to be drawn. If yes, 
-    then draw a cube or a point and then glPopMatrix() end the current 
-    object transformation.
-    */
-
-    for (float i = 0; i < xCubes; i++) {
-        for (float j = 0; j < yCubes; j++) {
-            for (float k = 0; k < zCubes; k++) {
-                glPushMatrix();
-                glTranslatef(
-                    i*delta() - xCubeSize/2,
-                    j*delta() - yCubeSize/2,
-                    k*delta() - zCubeSize/2);
-                if (noAnimation) {
-                    on = true;
-                } else if (waveAnimation || faceAnimation) { 
-                    on = isOn(i,j,k,t);
-                }
+        primitive = GL_POINTS;
+        if (level == 0) {
+            glPointSize(spacing*10);
+        } else {
+            glPointSize(std::min(spacing*10*step, std::max(1.0f, pixels*step)));
+        }
+    }
 
-                if (on || DRAW_OFF_LEDS_AS_TRANSLUSCENT) {
-                    glColor4f(1.0f, 1.0f, 1.0f, on ? 1.0 : transparency);
-                    if (mode == MODE_POINTS && (on || transparency)) {
-                        drawPoint();  
-                    } else if (mode == MODE_CUBES && (on || transparency)) {
-                        drawCube();  
-                    }
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    for (int n = 0; n < instances; n++) {
+        const LatticeState& state = states[stateCount == 1 ? 0 : n];
+        if (state.vertices.empty()) {
+            continue;
+        }
+        glVertexPointer(3, GL_FLOAT, 0, &state.vertices[0]);
+        glColorPointer(4, GL_UNSIGNED_BYTE, 0, &state.colors[0]);
+
+        Vector3 offset = instanceOffset(n);
+        glPushMatrix();
+        glTranslatef(offset.x, offset.y, offset.z);
+
+        // visible bricks that are next to each other in
+        // the vertex array are drawn with a single call
+        int first = 0;
+        int count = 0;
+        for (int b = 0; b < brickCount; b++) {
+            if (!brickVisible[n*brickCount + b] || state.brickCount[b] == 0) {
+                continue;
+            }
+            if (count > 0 && first + count == state.brickFirst[b]) {
+                count += state.brickCount[b];
+            } else {
+                if (count > 0) {
+                    glDrawArrays(primitive, first, count);
                 }
-                glPopMatrix();
-                
+                first = state.brickFirst[b];
+                count = state.brickCount[b];
             }
         }
+        if (count > 0) {
+            glDrawArrays(primitive, first, count);
+        }
+        glPopMatrix();
+    }
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+bool MatrixWidget::exportAnimation(const ExportSettings& exportSettings, QString* error) {
+    // the animation is stepped with a fixed timestep instead of the
+    // clock, so it can run faster or slower than realtime. every frame
+    // is rendered into a framebuffer object of the requested size and
+    // read back, encoding and writing happen on the exporter threads
+    // while the next frame is rendered.
+    makeCurrent();
+    if (!QGLFramebufferObject::hasOpenGLFramebufferObjects()) {
+        *error = "framebuffer objects are not supported";
+        return false;
+    }
+    QGLFramebufferObject fbo(exportSettings.width, exportSettings.height, QGLFramebufferObject::Depth);
+    if (!fbo.isValid()) {
+        *error = "could not create a framebuffer object";
+        return false;
+    }
+
+    FrameExporter exporter(exportSettings);
+    if (!exporter.start()) {
+        *error = exporter.errorString();
+        return false;
+    }
+
+    fbo.bind();
+    resizeGL(exportSettings.width, exportSettings.height);
+    double msPerFrame = 1000.0 * exportSettings.speed / exportSettings.fps;
+    for (int i = 0; i < exportSettings.frames; i++) {
+        renderFrame(qRound(i*msPerFrame));
+        QByteArray pixels(exportSettings.width*exportSettings.height*4, '\0');
+        glReadPixels(0, 0, exportSettings.width, exportSettings.height, GL_BGRA, GL_UNSIGNED_BYTE, pixels.data());
+        exporter.addFrame(pixels);
+    }
+    fbo.release();
+    resizeGL(width(), height());
+
+    if (!exporter.finish()) {
+        *error = exporter.errorString();
+        return false;
     }
+    return true;
 }
 
 void MatrixWidget::resizeGL(int w, int h) {
@@ -220,58 +451,16 @@ void MatrixWidget::resizeGL(int w, int h) {
     glLoadIdentity();
     float a = ((float) maxCube) * sqrt((float)3); 
     glViewport(0, 0, w, h);
+    viewportHeight = h;
     float z = zoom;
 
-    glFrustum(-(a/2)*aspect*z,(a/2)*aspect*z,-(a/2)*z,(a/2)*z,3*a,6*a);
+    // keep a copy of the projection for frustum culling in paintGL()
+    projection = Matrix4::frustum(-(a/2)*aspect*z,(a/2)*aspect*z,-(a/2)*z,(a/2)*z,3*a,6*a);
+    glLoadMatrixf(projection.data());
     
     glMatrixMode(GL_MODELVIEW);
 }
 
-// draw cube
-void MatrixWidget::drawCube() {
-    // draw The Cube Using quads
-    glBegin(GL_QUADS);
-    
-    glVertex3f(ledSize, ledSize, 0);
-    glVertex3f(0, ledSize, 0);
-    glVertex3f(0, ledSize, ledSize);
-    glVertex3f(ledSize, ledSize, ledSize);
-    
-    glVertex3f(ledSize, 0, ledSize);
-    glVertex3f(0, 0, ledSize);
-    glVertex3f(0, 0, 0);
-    glVertex3f(ledSize, 0, 0);
-    
-    glVertex3f(ledSize, ledSize, ledSize);
-    glVertex3f(0, ledSize, ledSize);
-    glVertex3f(0, 0, ledSize);
-    glVertex3f(ledSize, 0, ledSize);
-    
-    glVertex3f(ledSize, 0, 0);
-    glVertex3f(0, 0, 0);
-    glVertex3f(0, ledSize, 0);
-    glVertex3f(ledSize, ledSize, 0);
-    
-    glVertex3f(0, ledSize, ledSize);
-    glVertex3f(0, ledSize, 0);
-    glVertex3f(0, 0, 0);
-    glVertex3f(0, 0, ledSize);
-    
-    glVertex3f(ledSize, ledSize, 0);
-    glVertex3f(ledSize, ledSize, ledSize);
-    glVertex3f(ledSize, 0, ledSize);
-    glVertex3f(ledSize, 0, 0);
-
-    glEnd();   
-}
-
-// draw point
-void MatrixWidget::drawPoint() {
-    glBegin(GL_POINTS);
-    glVertex3f(0, 0, 0);   
-    glEnd();
-}
-
 static void qNormalizeAngle(int &angle) {
     while (angle < 0) angle += 360;
     while (angle > 360) angle -= 360;
@@ -357,6 +546,45 @@ void MatrixWidget::toggleDrawOff(bool draw) {
     //updateGL();
 }
 
+void MatrixWidget::setLevelOfDetail(bool enabled) {
+    levelOfDetail = enabled;
+    settings->setValue("levelOfDetail", levelOfDetail);
+}
+
+void MatrixWidget::setVolumeRendering(bool enabled) {
+    volumeRendering = enabled;
+    settings->setValue("volumeRendering", volumeRendering);
+
+    // the textures weren't kept up to date while it was off
+    volume.invalidate();
+}
+
+void MatrixWidget::setWallColumns(int columns) {
+    wallColumns = std::max(1, columns);
+    settings->setValue("wallColumns", wallColumns);
+    calcCubeSize();
+    resizeGL(width(), height());
+}
+
+void MatrixWidget::setWallRows(int rows) {
+    wallRows = std::max(1, rows);
+    settings->setValue("wallRows", wallRows);
+    calcCubeSize();
+    resizeGL(width(), height());
+}
+
+void MatrixWidget::setWallGap(int gap) {
+    wallGap = gap;
+    settings->setValue("wallGap", wallGap);
+    calcCubeSize();
+    resizeGL(width(), height());
+}
+
+void MatrixWidget::setWallPhase(int ms) {
+    wallPhase = ms;
+    settings->setValue("wallPhase", wallPhase);
+}
+
 void MatrixWidget::mousePressEvent(QMouseEvent *event) {
     lastPos = event->pos();
 }
@@ -388,105 +616,197 @@ void MatrixWidget::mouseMoveEvent(QMouseEvent *event) {
     lastPos = event->pos();
 }
 
-void MatrixWidget::setNoAnimation (bool set) {
-    // noAnimation on the LED cube widget
-    noAnimation = true;
-    waveAnimation = false;
-    faceAnimation = false;
+int MatrixWidget::layerCount() const {
+    return compositor.layerCount();
+}
+
+QString MatrixWidget::layerName(int layer) const {
+    return QString::fromStdString(compositor.layer(layer)->name());
+}
+
+bool MatrixWidget::isLayerEnabled(int layer) const {
+    return compositor.isEnabled(layer);
+}
+
+int MatrixWidget::layerOp(int layer) const {
+    return compositor.op(layer);
+}
+
+// a WAV file or "-" for stdin, see AudioLayer::open()
+bool MatrixWidget::openAudio(const QString& source) {
+    return audioLayer->open(source);
+}
+
+// the latency of the audio layer since the last call, see AudioLayer::takeLatency()
+int MatrixWidget::audioLatency(double& mean, double& max) {
+    return audioLayer->takeLatency(mean, max);
+}
+
+void MatrixWidget::setLayerEnabled(int layer, bool enabled) {
+    // the face and the mesh ask for their file every time they
+    // are switched on, the sequence for its directory. the audio
+    // only asks when nothing is playing yet
+    if (layer == LAYER_FACE && enabled) {
+        loadFace();
+    } else if (layer == LAYER_SEQUENCE && enabled) {
+        loadSequence();
+    } else if (layer == LAYER_MESH && enabled) {
+        loadMeshFile();
+    } else if (layer == LAYER_AUDIO && enabled && !audioLayer->isOpen()) {
+        loadAudio();
+    }
+    compositor.setEnabled(layer, enabled);
+}
+
+void MatrixWidget::setLayerOp(int layer, int op) {
+    compositor.setOp(layer, op);
+}
+
+void MatrixWidget::setSequenceFps(int fps) {
+    sequenceLayer->setFps(fps);
+    settings->setValue("sequenceFps", fps);
+}
+
+void MatrixWidget::setMeshSolid(bool solid) {
+    meshLayer->setSolid(solid);
+    settings->setValue("meshSolid", solid);
+    compositor.changed();
+}
+
+void MatrixWidget::setAutomatonRule(const QString& rule) {
+    // a rule that doesn't parse keeps the one before it
+    if (automatonLayer->setRule(rule.toStdString())) {
+        settings->setValue("automatonRule", rule);
+    }
+}
+
+void MatrixWidget::setAutomatonWrap(bool wrap) {
+    automatonLayer->setWrap(wrap);
+    settings->setValue("automatonWrap", wrap);
+}
+
+void MatrixWidget::setAutomatonSpeed(int stepsPerSecond) {
+    automatonLayer->setSpeed(stepsPerSecond);
+    settings->setValue("automatonSpeed", stepsPerSecond);
+}
+
+void MatrixWidget::setDriverMode(int mode) {
+    DriverSettings driverSettings = driver.settings();
+    driverSettings.mode = mode;
+    driver.setSettings(driverSettings);
+    settings->setValue("driverMode", mode);
+
+    // without the driver the layers draw straight into the LEDs,
+    // so they have to be drawn again when it is switched
+    compositor.changed();
+}
+
+void MatrixWidget::setDriverBits(int bits) {
+    DriverSettings driverSettings = driver.settings();
+    driverSettings.bits = bits;
+    driver.setSettings(driverSettings);
+    settings->setValue("driverBits", bits);
 }
 
-void MatrixWidget::setWaveAnimation (bool set) {
-    // WaveAnimation on the LED cube widget
-    noAnimation = false;
-    waveAnimation = true;
-    faceAnimation = false;
+void MatrixWidget::setDriverRefreshRate(int hz) {
+    DriverSettings driverSettings = driver.settings();
+    driverSettings.refreshRate = hz;
+    driver.setSettings(driverSettings);
+    settings->setValue("driverRefreshRate", hz);
 }
 
-void MatrixWidget::setFaceAnimation (bool set) {
-    /* these boolean variables are flags for 
-       drawing animations in the widget. */
-    noAnimation = false;                                
-    waveAnimation = false;                              
-    faceAnimation = true;
+void MatrixWidget::setDriverExposure(int ms) {
+    DriverSettings driverSettings = driver.settings();
+    driverSettings.exposure = ms;
+    driver.setSettings(driverSettings);
+    settings->setValue("driverExposure", ms);
+}
+
+void MatrixWidget::setDriverMultiplex(bool multiplex) {
+    DriverSettings driverSettings = driver.settings();
+    driverSettings.multiplex = multiplex;
+    driver.setSettings(driverSettings);
+    settings->setValue("driverMultiplex", multiplex);
+}
 
+void MatrixWidget::loadFace() {
     // create a vector of vertices
     // open the file window to input the file to QString
-    Vertices = new std::vector<Vector3>;          
+    std::vector<Vector3> points;
     QString file = QFileDialog::getOpenFileName(
         this,
         tr("Open XYZ File"),
         tr("XYZ file (.xyz)")
         );
 
-    // if the file is not empty then read from the file
-    // create an object of Qfile and then open the QFile
-    // converts file to textstream, read until end of file,
+    // if the file is not empty then read the points from it,
+    // the layer scales them so that they fit into the cube
     if(!file.isEmpty()) {
-        QFile sfile(file);
-        if(sfile.open(QFile::ReadOnly)) {
-            QTextStream in (&sfile);
-            while (!in.atEnd()) {
-                // read the row and places the row in QString line
-                // QByteArray provides an array of bytes
-                // set str char to the data stored in the byte array
-                QString line = in.readLine();
-                QByteArray ba = line.toLocal8Bit();
-                const char* str = ba.data();
-
-                // create a object of type Vector3
-                Vector3 v;                       
-
-                // reads the first char in the line as x coordinate
-                // reads the second char in the line as y coordinate
-                // reads the third char in the line as z coordinate
-                v.x = strtof(str, (char**)&str);
-                v.y = strtof(str, (char**)&str);
-                v.z = strtof(str, (char**)&str);    
-
-                // adds the object to the vector of vertices
-                Vertices->push_back(v);            
+        loadXYZ(file, points);
+    }
+    faceLayer->setPoints(points);
+    compositor.changed();
+}
+
+void MatrixWidget::loadSequence() {
+    // a directory with one .xyz file per frame, played
+    // in the order of the file names
+    QString directory = QFileDialog::getExistingDirectory(
+        this,
+        tr("Open Point Cloud Sequence")
+        );
+    if (!directory.isEmpty()) {
+        sequenceLayer->open(directory);
+    }
+}
+
+void MatrixWidget::loadMeshFile() {
+    // the layer scales the mesh so that it fits into the cube
+    std::vector<Triangle> triangles;
+    QString file = QFileDialog::getOpenFileName(
+        this,
+        tr("Open Mesh"),
+        QString(),
+        tr("Mesh (*.obj *.stl)")
+        );
+    if (!file.isEmpty() && !loadMesh(file, triangles)) {
+        std::cerr << "can't read mesh " << file.toLocal8Bit().constData() << std::endl;
+    }
+    meshLayer->setTriangles(triangles);
+    compositor.changed();
+}
+
+void MatrixWidget::loadAudio() {
+    QString file = QFileDialog::getOpenFileName(
+        this,
+        tr("Open Audio"),
+        QString(),
+        tr("WAV (*.wav);;Raw PCM (*)")
+        );
+    if (!file.isEmpty() && !audioLayer->open(file)) {
+        std::cerr << "can't open audio " << file.toLocal8Bit().constData() << std::endl;
+    }
+}
+
+void MatrixWidget::loadPluginLayers() {
+    // every plugin in the plugin directory becomes a layer after the
+    // built in ones. their parameters come from the settings
+    QString directory = settings->value("pluginDirectory",
+        QCoreApplication::applicationDirPath() + "/plugins").toString();
+    QStringList errors;
+    std::vector<PluginLayer*> plugins = loadPlugins(directory, &errors);
+    for (size_t n = 0; n < plugins.size(); n++) {
+        PluginLayer* plugin = plugins[n];
+        QString prefix = "plugins/" + QString::fromStdString(plugin->name()) + "/";
+        for (int p = 0; p < plugin->parameterCount(); p++) {
+            QString key = prefix + plugin->parameterName(p);
+            if (settings->contains(key)) {
+                plugin->setParameter(p, settings->value(key).toFloat());
             }
-            // close the file
-            sfile.close();
         }
+        compositor.addLayer(plugin);
     }
-
-    // maximum and minimum from the data set
-    float xMax = 0.0;
-    float yMax = 0.0;
-    float zMax = 0.0;
-    float xMin = 0.0;
-    float yMin = 0.0;
-    float zMin = 0.0;
-
-    // iterate the vertices vector and find the max and min the data
-    for (std::vector<Vector3>::iterator it = Vertices->begin(); 
-                            it != Vertices->end(); ++it){
-
-        xMax = std::max(xMax, it->x);     
-        yMax = std::max(yMax, it->y);     
-        zMax = std::max(zMax, it->z);
-        xMin = std::min(xMin, it->x);     
-        yMin = std::min(yMin, it->y);     
-        zMin = std::min(zMin, it->z); 
-    }
-
-    // maximum and minimum from the normalized set
-    float xnormmax = xCubes;
-    float xnormmin = 1;
-    float ynormmax = yCubes;
-    float ynormmin = 1;
-    float znormmax = zCubes;
-    float znormmin = 1;
-
-    // iterate the vertices vector and normalize the data
-    for (std::vector<Vector3>::iterator it = Vertices->begin();
-                            it != Vertices->end(); ++it) {
-        it->x =  floor( xnormmin + ((it->x - xMin) 
-                * (xnormmax - xnormmin))/(xMax - xMin) );
-        it->y =  floor( ynormmin + ((it->y - yMin) 
-                * (ynormmax - ynormmin))/(yMax - yMin) );
-        it->z =  floor( znormmin + ((it->z - zMin) 
-                * (znormmax - znormmin))/(zMax - zMin) );
-    }
-}
\ No newline at end of file
+    for (int n = 0; n < errors.count(); n++) {
+        std::cerr << "skipped plugin " << errors.at(n).toLocal8Bit().constData() << std::endl;
+    }
+}
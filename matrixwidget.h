@@ -19,6 +19,17 @@
 #include <QSettings>
 #include <ctime>
 #include <QWheelEvent>
+#include <vector>
+#include "lattice.h"
+#include "layers.h"
+#include "driver.h"
+#include "sequence.h"
+#include "mesh.h"
+#include "automaton.h"
+#include "particles.h"
+#include "audio.h"
+#include "volume.h"
+#include "exporter.h"
 
 //! LEDMatrix Widget
 /*!
@@ -26,10 +37,6 @@
     
 */
 
-struct Vector3 {
-    float x, y, z;
-};
-
 class MatrixWidget : public QGLWidget
 {
     Q_OBJECT
@@ -38,6 +45,15 @@ public:
     MatrixWidget(QWidget *parent = 0);
     enum { MODE_CUBES, MODE_POINTS };                       // able to change the mode from cubes to points or vice versa
     bool DRAW_OFF_LEDS_AS_TRANSLUSCENT;                     // decides whether or not to draw the leds that are off
+    enum { LAYER_ALL_ON, LAYER_WAVE, LAYER_FACE, LAYER_GRADIENT, LAYER_SEQUENCE, LAYER_MESH,
+           LAYER_AUTOMATON, LAYER_RAIN, LAYER_SNOW, LAYER_FIREWORKS, LAYER_AUDIO };     // the layers every widget starts out with
+    bool exportAnimation(const ExportSettings& settings, QString* error);
+    int layerCount() const;
+    QString layerName(int layer) const;
+    bool isLayerEnabled(int layer) const;
+    int layerOp(int layer) const;
+    bool openAudio(const QString& source);
+    int audioLatency(double& mean, double& max);
 
 public slots:
     void setXRotation(int angle);
@@ -51,10 +67,25 @@ public slots:
     void setYSize(int size);
     void setZSize(int size);
     void toggleDrawOff(bool draw);
+    void setLevelOfDetail(bool enabled);
+    void setVolumeRendering(bool enabled);
+    void setWallColumns(int columns);
+    void setWallRows(int rows);
+    void setWallGap(int gap);
+    void setWallPhase(int ms);
 
-    void setNoAnimation     (bool);
-    void setWaveAnimation   (bool);
-    void setFaceAnimation   (bool);
+    void setLayerEnabled(int layer, bool enabled);
+    void setLayerOp(int layer, int op);
+    void setSequenceFps(int fps);
+    void setMeshSolid(bool solid);
+    void setAutomatonRule(const QString& rule);
+    void setAutomatonWrap(bool wrap);
+    void setAutomatonSpeed(int stepsPerSecond);
+    void setDriverMode(int mode);
+    void setDriverBits(int bits);
+    void setDriverRefreshRate(int hz);
+    void setDriverExposure(int ms);
+    void setDriverMultiplex(bool multiplex);
     
 signals:
     void xRotationChanged(int angle);
@@ -64,21 +95,33 @@ signals:
     void zoomChanged(int rawZoom);
 
 protected:
-    void drawCube();
-    void drawPoint(); 
     void initializeGL();
     void paintGL();
+    void renderFrame(int t);
     void resizeGL(int width, int height);
     void mousePressEvent(QMouseEvent *event);
     void mouseMoveEvent(QMouseEvent *event);
     void wheelEvent(QWheelEvent* event);
     QSize sizeHint() const;
     void calcCubeSize();
+    float pixelsPerLed(float a);
+    int lodLevel(float pixels);
+    Vector3 instanceOffset(int n);
+    bool isAnimated();
+    void resizeStates(int count);
+    bool updateLeds(int s, int t);
+    void updateState(int s, int level, int t);
     float delta();
-    bool isOn(int x, int y, int z, int t);
+    void loadFace();
+    void loadSequence();
+    void loadMeshFile();
+    void loadAudio();
+    void loadPluginLayers();
     void perspective(GLdouble fovy, GLdouble aspect, GLdouble zNear, GLdouble zFar);
 
 private:
+    enum { LOD_MIN_PIXELS = 2 };                            // switch to a coarser level below this many pixels per cell
+
     int rawZoom;
     int mode;
     int xRot;
@@ -96,11 +139,28 @@ private:
     float zCubeSize;
     float maxCube;
     float zoom;
+    LatticeGeometry geometry;
+    Matrix4 projection;                                     // same matrix resizeGL() passes to glFrustum()
+    std::vector<Brick> bricks;
+    std::vector<LatticeState> states;                       // one per animation phase shown on the wall
+    std::vector<char> brickVisible;                         // per cube of the wall, per brick
+    std::vector<char> brickNeeded;                          // per brick, visible in a cube showing the state
+    bool levelOfDetail;
+    bool volumeRendering;                                   // ray-march the LEDs on the GPU instead of building vertices
+    VolumeRenderer volume;                                  // 3D textures of the states, if volumeRendering
+    int viewportHeight;
+    int wallColumns;                                        // cubes next to each other (along x)
+    int wallRows;                                           // cubes on top of each other (along y)
+    int wallGap;                                            // space between cubes, in LEDs
+    int wallPhase;                                          // animation time offset from one cube to the next, in ms
     QSettings * settings;
-    std::vector<Vector3>* Vertices;
-    bool faceAnimation;
-    bool waveAnimation;
-    bool noAnimation;
+    Compositor compositor;                                  // the animation layers
+    PointCloudLayer* faceLayer;
+    SequenceLayer* sequenceLayer;
+    MeshLayer* meshLayer;
+    AutomatonLayer* automatonLayer;
+    AudioLayer* audioLayer;
+    LedDriver driver;                                       // BAM / PWM simulation of the brightness
 };
 
 #endif
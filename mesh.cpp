@@ -0,0 +1,437 @@
+/*  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
+
+ > Triangle meshes from OBJ and binary STL files, and turning them into
+ > LEDs: either every LED the surface touches, or the whole solid.
+
+ > Copyright (C) 2014 by Daniel Intskirveli, Gurpreet Singh, Christopher Zhang.
+
+ > mesh.cpp - mesh loading and voxelization.
+
+ > Written by: Daniel Intskirveli, Gurpreet Singh, Christopher Zhang, 2014.
+
+  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_ */
+
+#include "mesh.h"
+#include "animations.h"
+#include "voxelgrid.h"
+#include <QFile>
+#include <QThread>
+#include <QAtomicInt>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+bool loadOBJ(const QString& file, std::vector<Triangle>& triangles) {
+    QFile sfile(file);
+    if (!sfile.open(QFile::ReadOnly)) {
+        return false;
+    }
+    QByteArray data = sfile.readAll();
+    sfile.close();
+
+    // only "v x y z" and "f a b c ..." lines matter. a face corner can
+    // be "a", "a/t", "a//n" or "a/t/n", negative indices count back
+    // from the last vertex so far
+    std::vector<Vector3> vertices;
+    std::vector<int> face;
+    const char* str = data.constData();
+    const char* last = str + data.size();
+    while (str < last) {
+        const char* end = (const char*) memchr(str, '\n', last - str);
+        if (!end) {
+            end = last;
+        }
+        if (str[0] == 'v' && (str[1] == ' ' || str[1] == '\t')) {
+            // a coordinate that is missing is 0, like in loadXYZ(),
+            // parseFloat() would take it from the next line
+            const char* p = str + 1;
+            float coordinates[3];
+            for (int i = 0; i < 3; i++) {
+                char* next;
+                coordinates[i] = parseFloat(p, &next);
+                if (next == p || next > end) {
+                    coordinates[i] = 0;
+                    p = end;
+                } else {
+                    p = next;
+                }
+            }
+            Vector3 v = { coordinates[0], coordinates[1], coordinates[2] };
+            vertices.push_back(v);
+        } else if (str[0] == 'f' && (str[1] == ' ' || str[1] == '\t')) {
+            face.clear();
+            const char* p = str + 1;
+            while (p < end) {
+                char* next;
+                long index = strtol(p, &next, 10);
+                if (next == p || next > end) {
+                    break;
+                }
+                index = index < 0 ? (long) vertices.size() + index : index - 1;
+                if (index < 0 || index >= (long) vertices.size()) {
+                    face.clear();
+                    break;
+                }
+                face.push_back(index);
+                // skip the texture and normal indices
+                p = next;
+                while (p < end && *p != ' ' && *p != '\t') {
+                    p++;
+                }
+            }
+            for (size_t i = 2; i < face.size(); i++) {
+                Triangle t = { vertices[face[0]], vertices[face[i - 1]], vertices[face[i]] };
+                triangles.push_back(t);
+            }
+        }
+        str = end + 1;
+    }
+    return true;
+}
+
+bool loadSTL(const QString& file, std::vector<Triangle>& triangles) {
+    // an 80 byte header, the number of triangles, then 50 bytes per
+    // triangle: the normal, the three corners and two unused bytes.
+    // everything is little endian, like the machines this runs on
+    QFile sfile(file);
+    if (!sfile.open(QFile::ReadOnly)) {
+        return false;
+    }
+    QByteArray data = sfile.readAll();
+    sfile.close();
+    if (data.size() < 84) {
+        return false;
+    }
+    unsigned int count;
+    memcpy(&count, data.constData() + 80, 4);
+    if ((qint64) data.size() < 84 + (qint64) count*50) {
+        return false;
+    }
+
+    const char* record = data.constData() + 84;
+    size_t first = triangles.size();
+    triangles.resize(first + count);
+    for (unsigned int i = 0; i < count; i++, record += 50) {
+        float corners[9];
+        memcpy(corners, record + 12, sizeof(corners));
+        Triangle& t = triangles[first + i];
+        t.a.x = corners[0]; t.a.y = corners[1]; t.a.z = corners[2];
+        t.b.x = corners[3]; t.b.y = corners[4]; t.b.z = corners[5];
+        t.c.x = corners[6]; t.c.y = corners[7]; t.c.z = corners[8];
+    }
+    return true;
+}
+
+bool loadMesh(const QString& file, std::vector<Triangle>& triangles) {
+    if (file.endsWith(".stl", Qt::CaseInsensitive)) {
+        return loadSTL(file, triangles);
+    }
+    return loadOBJ(file, triangles);
+}
+
+// everything the slabs share while the mesh is voxelized
+struct VoxelizeJob {
+    std::vector<Triangle> triangles;                        // in LED coordinates, LED x covers [x, x + 1)
+    std::vector<std::vector<int> > bins;                    // the triangles reaching into every slab
+    int slabSize;                                           // LEDs along x per slab
+    bool solid;
+    VoxelGrid cells;                                        // 255 for the LEDs that are on
+    QAtomicInt nextSlab;
+};
+
+static inline float dot(const Vector3& a, const Vector3& b) {
+    return a.x*b.x + a.y*b.y + a.z*b.z;
+}
+
+static inline Vector3 subtract(const Vector3& a, const Vector3& b) {
+    Vector3 v = { a.x - b.x, a.y - b.y, a.z - b.z };
+    return v;
+}
+
+// separating axis test of the triangle against the cell with its center
+// at c (Akenine-Moeller). touching counts as overlapping, and the cell is
+// grown by a hair so that rounding never loses a cell the surface is on.
+// the axes of the cell are left out, the caller only asks for cells in
+// the bounding box of the triangle.
+static bool overlapsCell(const Triangle& t, const Vector3* edges, const Vector3& normal, const Vector3& c) {
+    const float half = 0.5f + 1e-5f;
+    Vector3 v[3] = { subtract(t.a, c), subtract(t.b, c), subtract(t.c, c) };
+
+    // the plane of the triangle
+    float r = half*(fabs(normal.x) + fabs(normal.y) + fabs(normal.z));
+    if (fabs(dot(normal, v[0])) > r) {
+        return false;
+    }
+
+    // cross products of the edges with the axes of the cell
+    for (int i = 0; i < 3; i++) {
+        const Vector3& e = edges[i];
+        float p0, p1, p2;
+
+        p0 = e.y*v[0].z - e.z*v[0].y;
+        p1 = e.y*v[1].z - e.z*v[1].y;
+        p2 = e.y*v[2].z - e.z*v[2].y;
+        r = half*(fabs(e.y) + fabs(e.z));
+        if (std::min(p0, std::min(p1, p2)) > r || std::max(p0, std::max(p1, p2)) < -r) {
+            return false;
+        }
+
+        p0 = e.z*v[0].x - e.x*v[0].z;
+        p1 = e.z*v[1].x - e.x*v[1].z;
+        p2 = e.z*v[2].x - e.x*v[2].z;
+        r = half*(fabs(e.x) + fabs(e.z));
+        if (std::min(p0, std::min(p1, p2)) > r || std::max(p0, std::max(p1, p2)) < -r) {
+            return false;
+        }
+
+        p0 = e.x*v[0].y - e.y*v[0].x;
+        p1 = e.x*v[1].y - e.y*v[1].x;
+        p2 = e.x*v[2].y - e.y*v[2].x;
+        r = half*(fabs(e.x) + fabs(e.y));
+        if (std::min(p0, std::min(p1, p2)) > r || std::max(p0, std::max(p1, p2)) < -r) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// edge function of the point p against the edge a -> b, projected along z
+static inline float edge(const Vector3& a, const Vector3& b, float px, float py) {
+    return (b.x - a.x)*(py - a.y) - (b.y - a.y)*(px - a.x);
+}
+
+// whether a point on the edge a -> b of a counter clockwise triangle
+// belongs to it. like the fill rule of a rasterizer, so that a ray through
+// an edge or corner the mesh shares is counted by exactly one triangle
+static inline bool isTopLeft(const Vector3& a, const Vector3& b) {
+    return b.y < a.y || (b.y == a.y && b.x < a.x);
+}
+
+// a point where a ray along z crosses the mesh
+struct RayHit {
+    int ray;
+    float z;
+    bool operator<(const RayHit& other) const {
+        return ray < other.ray || (ray == other.ray && z < other.z);
+    }
+};
+
+static void voxelizeSlab(VoxelizeJob& job, int slab) {
+    VoxelGrid& cells = job.cells;
+    int w = cells.width();
+    int h = cells.height();
+    int d = cells.depth();
+    int x0 = slab*job.slabSize;
+    int x1 = std::min(x0 + job.slabSize, w);
+    const std::vector<int>& bin = job.bins[slab];
+    std::vector<RayHit> hits;
+
+    for (size_t n = 0; n < bin.size(); n++) {
+        const Triangle& t = job.triangles[bin[n]];
+        Vector3 edges[3] = { subtract(t.b, t.a), subtract(t.c, t.b), subtract(t.a, t.c) };
+        Vector3 normal = { edges[0].y*edges[1].z - edges[0].z*edges[1].y,
+                           edges[0].z*edges[1].x - edges[0].x*edges[1].z,
+                           edges[0].x*edges[1].y - edges[0].y*edges[1].x };
+        Vector3 min = { std::min(t.a.x, std::min(t.b.x, t.c.x)), std::min(t.a.y, std::min(t.b.y, t.c.y)),
+                        std::min(t.a.z, std::min(t.b.z, t.c.z)) };
+        Vector3 max = { std::max(t.a.x, std::max(t.b.x, t.c.x)), std::max(t.a.y, std::max(t.b.y, t.c.y)),
+                        std::max(t.a.z, std::max(t.b.z, t.c.z)) };
+
+        // the surface: every cell in the bounding box the triangle touches
+        // (a triangle on the far side of the cube is in the last cell, one
+        // that rounding puts just below 0 in the first)
+        int xs = std::max(x0, std::min(w - 1, (int) floor(min.x))), xe = std::min(x1 - 1, (int) floor(max.x));
+        int ys = std::max(0, std::min(h - 1, (int) floor(min.y))), ye = std::min(h - 1, (int) floor(max.y));
+        int zs = std::max(0, std::min(d - 1, (int) floor(min.z))), ze = std::min(d - 1, (int) floor(max.z));
+        for (int x = xs; x <= xe; x++) {
+            for (int y = ys; y <= ye; y++) {
+                unsigned char* row = cells.data() + cells.index(x, y, 0);
+                for (int z = zs; z <= ze; z++) {
+                    Vector3 center = { x + 0.5f, y + 0.5f, z + 0.5f };
+                    if (!row[z] && overlapsCell(t, edges, normal, center)) {
+                        row[z] = 255;
+                    }
+                }
+            }
+        }
+
+        if (!job.solid) {
+            continue;
+        }
+
+        // the inside: where the rays through the centers of the cells
+        // along z cross the triangle. triangles seen edge on don't count
+        Vector3 a = t.a, b = t.b, c = t.c;
+        float area = edge(a, b, c.x, c.y);
+        if (area == 0) {
+            continue;
+        }
+        if (area < 0) {
+            std::swap(b, c);
+            area = -area;
+        }
+        bool topLeft[3] = { isTopLeft(b, c), isTopLeft(c, a), isTopLeft(a, b) };
+        xs = std::max(x0, (int) ceil(min.x - 0.5f));
+        xe = std::min(x1 - 1, (int) floor(max.x - 0.5f));
+        ys = std::max(0, (int) ceil(min.y - 0.5f));
+        ye = std::min(h - 1, (int) floor(max.y - 0.5f));
+        for (int x = xs; x <= xe; x++) {
+            for (int y = ys; y <= ye; y++) {
+                float px = x + 0.5f;
+                float py = y + 0.5f;
+                float w0 = edge(b, c, px, py);
+                float w1 = edge(c, a, px, py);
+                float w2 = edge(a, b, px, py);
+                if ((w0 > 0 || (w0 == 0 && topLeft[0])) &&
+                    (w1 > 0 || (w1 == 0 && topLeft[1])) &&
+                    (w2 > 0 || (w2 == 0 && topLeft[2]))) {
+                    RayHit hit;
+                    hit.ray = (x - x0)*h + y;
+                    hit.z = (w0*a.z + w1*b.z + w2*c.z) / area;
+                    hits.push_back(hit);
+                }
+            }
+        }
+    }
+
+    // a ray is inside the mesh between every second pair of crossings,
+    // turn on the cells with their center in there
+    std::sort(hits.begin(), hits.end());
+    for (size_t i = 0; i + 1 < hits.size(); i++) {
+        if (hits[i].ray != hits[i + 1].ray) {
+            continue;
+        }
+        int x = x0 + hits[i].ray / h;
+        int y = hits[i].ray % h;
+        int zs = std::max(0, (int) ceil(hits[i].z - 0.5f));
+        int ze = std::min(d, (int) ceil(hits[i + 1].z - 0.5f));
+        if (zs < ze) {
+            memset(cells.data() + cells.index(x, y, zs), 255, ze - zs);
+        }
+        i++;
+    }
+}
+
+//! Takes slabs off the job until there are none left
+class VoxelizeThread : public QThread
+{
+public:
+    VoxelizeThread(VoxelizeJob* job) : job(job) {}
+
+    static void work(VoxelizeJob* job) {
+        int slabs = job->bins.size();
+        int slab;
+        while ((slab = job->nextSlab.fetchAndAddOrdered(1)) < slabs) {
+            voxelizeSlab(*job, slab);
+        }
+    }
+
+protected:
+    void run() {
+        work(job);
+    }
+
+private:
+    VoxelizeJob* job;
+};
+
+static inline Vector3 scalePoint(const Vector3& p, float scale, const Vector3& offset) {
+    Vector3 v = { p.x*scale + offset.x, p.y*scale + offset.y, p.z*scale + offset.z };
+    return v;
+}
+
+void voxelizeMesh(const std::vector<Triangle>& triangles, BitPlane& plane, bool solid) {
+    int w = plane.width();
+    int h = plane.height();
+    int d = plane.depth();
+    plane.fill(false);
+    if (triangles.empty() || w*h*d == 0) {
+        return;
+    }
+
+    // scale the mesh to fit into the cube in its longest direction
+    // and center it in the others
+    Vector3 min = triangles[0].a, max = triangles[0].a;
+    for (size_t i = 0; i < triangles.size(); i++) {
+        const Triangle& t = triangles[i];
+        min.x = std::min(min.x, std::min(t.a.x, std::min(t.b.x, t.c.x)));
+        min.y = std::min(min.y, std::min(t.a.y, std::min(t.b.y, t.c.y)));
+        min.z = std::min(min.z, std::min(t.a.z, std::min(t.b.z, t.c.z)));
+        max.x = std::max(max.x, std::max(t.a.x, std::max(t.b.x, t.c.x)));
+        max.y = std::max(max.y, std::max(t.a.y, std::max(t.b.y, t.c.y)));
+        max.z = std::max(max.z, std::max(t.a.z, std::max(t.b.z, t.c.z)));
+    }
+    float scale = 0;
+    if (max.x > min.x) scale = w / (max.x - min.x);
+    if (max.y > min.y) scale = scale ? std::min(scale, h / (max.y - min.y)) : h / (max.y - min.y);
+    if (max.z > min.z) scale = scale ? std::min(scale, d / (max.z - min.z)) : d / (max.z - min.z);
+    if (scale == 0) {
+        scale = 1;
+    }
+    Vector3 offset = { w/2.0f - (min.x + max.x)/2*scale,
+                       h/2.0f - (min.y + max.y)/2*scale,
+                       d/2.0f - (min.z + max.z)/2*scale };
+
+    // slabs of a few planes, about 8 for every thread
+    // so that a slab with many triangles doesn't hold up the rest
+    int threads = std::max(1, QThread::idealThreadCount());
+    VoxelizeJob job;
+    job.solid = solid;
+    job.slabSize = std::max(2, w / (threads*8));
+    job.bins.resize((w + job.slabSize - 1) / job.slabSize);
+    job.cells.resize(w, h, d);
+    job.cells.fill(0);
+    job.triangles.resize(triangles.size());
+    for (size_t i = 0; i < triangles.size(); i++) {
+        Triangle& t = job.triangles[i];
+        t.a = scalePoint(triangles[i].a, scale, offset);
+        t.b = scalePoint(triangles[i].b, scale, offset);
+        t.c = scalePoint(triangles[i].c, scale, offset);
+        float xMin = std::min(t.a.x, std::min(t.b.x, t.c.x));
+        float xMax = std::max(t.a.x, std::max(t.b.x, t.c.x));
+        int first = std::max(0, std::min(w - 1, (int) floor(xMin))) / job.slabSize;
+        int last = std::min(w - 1, (int) floor(xMax)) / job.slabSize;
+        for (int s = first; s <= last; s++) {
+            job.bins[s].push_back(i);
+        }
+    }
+
+    std::vector<VoxelizeThread*> helpers;
+    for (int i = 1; i < threads; i++) {
+        helpers.push_back(new VoxelizeThread(&job));
+        helpers.back()->start();
+    }
+    VoxelizeThread::work(&job);
+    for (size_t i = 0; i < helpers.size(); i++) {
+        helpers[i]->wait();
+        delete helpers[i];
+    }
+
+    plane.pack(job.cells.data());
+}
+
+void MeshLayer::resize(int width, int height, int depth) {
+    voxels.resize(width, height, depth);
+    voxelize();
+}
+
+void MeshLayer::render(BitPlane& plane, int) {
+    if (voxels.wordCount() == plane.wordCount()) {
+        std::copy(voxels.data(), voxels.data() + voxels.wordCount(), plane.data());
+    }
+}
+
+void MeshLayer::setTriangles(const std::vector<Triangle>& newTriangles) {
+    triangles = newTriangles;
+    voxelize();
+}
+
+void MeshLayer::setSolid(bool fill) {
+    solid = fill;
+    voxelize();
+}
+
+void MeshLayer::voxelize() {
+    voxelizeMesh(triangles, voxels, solid);
+}
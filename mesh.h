@@ -0,0 +1,63 @@
+/*  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
+
+ > Triangle meshes from OBJ and binary STL files, and turning them into
+ > LEDs: either every LED the surface touches, or the whole solid.
+
+ > Copyright (C) 2014 by Daniel Intskirveli, Gurpreet Singh, Christopher Zhang.
+
+ > mesh.h - mesh loading and voxelization.
+
+ > Written by: Daniel Intskirveli, Gurpreet Singh, Christopher Zhang, 2014.
+
+  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_ */
+
+#ifndef MESH_H
+#define MESH_H
+
+#include <QString>
+#include <vector>
+#include "frustum.h"
+#include "bitplane.h"
+#include "compositor.h"
+
+struct Triangle {
+    Vector3 a, b, c;
+};
+
+// appends the triangles of a Wavefront .obj file, polygons are split into fans
+bool loadOBJ(const QString& file, std::vector<Triangle>& triangles);
+
+// appends the triangles of a binary .stl file
+bool loadSTL(const QString& file, std::vector<Triangle>& triangles);
+
+// loadOBJ() or loadSTL(), by the extension of the file
+bool loadMesh(const QString& file, std::vector<Triangle>& triangles);
+
+// turns on every LED whose cell the mesh touches, scaled to fit the plane
+// and centered in it, keeping its proportions. with solid the LEDs inside
+// the mesh are turned on as well, that needs a closed mesh. the work is
+// split into slabs along x, one thread per core.
+void voxelizeMesh(const std::vector<Triangle>& triangles, BitPlane& plane, bool solid);
+
+//! A mesh voxelized into the cube
+class MeshLayer : public Layer
+{
+public:
+    MeshLayer() : solid(false) {}
+
+    std::string name() const { return "Mesh Model"; }
+    void resize(int width, int height, int depth);
+    void render(BitPlane& plane, int t);
+
+    void setTriangles(const std::vector<Triangle>& triangles);
+    void setSolid(bool solid);
+
+private:
+    void voxelize();
+
+    std::vector<Triangle> triangles;
+    bool solid;
+    BitPlane voxels;                                        // the mesh for the current size
+};
+
+#endif
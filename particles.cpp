@@ -0,0 +1,325 @@
+/*  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
+
+ > ParticleSystem class, a fixed pool of moving points, and the rain,
+ > snow and fireworks layers made out of it.
+
+ > Copyright (C) 2014 by Daniel Intskirveli, Gurpreet Singh, Christopher Zhang.
+
+ > particles.cpp - particle effects.
+
+ > Written by: Daniel Intskirveli, Gurpreet Singh, Christopher Zhang, 2014.
+
+  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_ */
+
+#include "particles.h"
+#include <algorithm>
+#include <cmath>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+ParticleSystem::ParticleSystem() : n(0), width(0), height(0), depth(0), drag(0) {
+    gravity.x = gravity.y = gravity.z = 0;
+}
+
+void ParticleSystem::setCapacity(int particles) {
+    std::vector<float>* arrays[] = { &px, &py, &pz, &vx, &vy, &vz, &life };
+    for (int i = 0; i < 7; i++) {
+        arrays[i]->assign(particles, 0.0f);
+    }
+    n = 0;
+}
+
+void ParticleSystem::setBounds(int w, int h, int d) {
+    width = (float) w;
+    height = (float) h;
+    depth = (float) d;
+}
+
+void ParticleSystem::setGravity(const Vector3& acceleration) {
+    gravity = acceleration;
+}
+
+void ParticleSystem::setDrag(float perSecond) {
+    drag = std::max(0.0f, perSecond);
+}
+
+bool ParticleSystem::spawn(const Vector3& position, const Vector3& velocity, float lifeTime) {
+    if (n >= capacity()) {
+        return false;
+    }
+    px[n] = position.x;
+    py[n] = position.y;
+    pz[n] = position.z;
+    vx[n] = velocity.x;
+    vy[n] = velocity.y;
+    vz[n] = velocity.z;
+    life[n] = lifeTime;
+    n++;
+    return true;
+}
+
+void ParticleSystem::update(float dt, std::vector<Vector3>* expired) {
+    if (n == 0) {
+        return;
+    }
+
+    // moves and ages everything in one go through the arrays, and
+    // remembers whether anything died on the way. most frames nothing
+    // does and the loop below that takes the dead out is skipped
+    float damping = exp(-drag*dt);
+    float dvx = gravity.x*dt, dvy = gravity.y*dt, dvz = gravity.z*dt;
+    float* l = &life[0];
+    int i = 0;
+    bool dead = false;
+#ifdef __SSE2__
+    __m128 damping4 = _mm_set1_ps(damping);
+    __m128 dt4 = _mm_set1_ps(dt);
+    __m128 dvx4 = _mm_set1_ps(dvx), dvy4 = _mm_set1_ps(dvy), dvz4 = _mm_set1_ps(dvz);
+    __m128 w4 = _mm_set1_ps(width), h4 = _mm_set1_ps(height), d4 = _mm_set1_ps(depth);
+    __m128 zero = _mm_setzero_ps();
+    __m128 anyDead = zero;
+    for (; i + 4 <= n; i += 4) {
+        __m128 vx4 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&vx[i]), damping4), dvx4);
+        __m128 vy4 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&vy[i]), damping4), dvy4);
+        __m128 vz4 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&vz[i]), damping4), dvz4);
+        __m128 x = _mm_add_ps(_mm_loadu_ps(&px[i]), _mm_mul_ps(vx4, dt4));
+        __m128 y = _mm_add_ps(_mm_loadu_ps(&py[i]), _mm_mul_ps(vy4, dt4));
+        __m128 z = _mm_add_ps(_mm_loadu_ps(&pz[i]), _mm_mul_ps(vz4, dt4));
+        __m128 left = _mm_sub_ps(_mm_loadu_ps(l + i), dt4);
+        _mm_storeu_ps(&vx[i], vx4);
+        _mm_storeu_ps(&vy[i], vy4);
+        _mm_storeu_ps(&vz[i], vz4);
+        _mm_storeu_ps(&px[i], x);
+        _mm_storeu_ps(&py[i], y);
+        _mm_storeu_ps(&pz[i], z);
+        _mm_storeu_ps(l + i, left);
+
+        __m128 outside = _mm_or_ps(_mm_or_ps(_mm_cmplt_ps(x, zero), _mm_cmpge_ps(x, w4)),
+                                   _mm_or_ps(_mm_cmplt_ps(y, zero), _mm_cmpge_ps(y, h4)));
+        outside = _mm_or_ps(outside, _mm_or_ps(_mm_cmplt_ps(z, zero), _mm_cmpge_ps(z, d4)));
+        anyDead = _mm_or_ps(anyDead, _mm_or_ps(outside, _mm_cmple_ps(left, zero)));
+    }
+    dead = _mm_movemask_ps(anyDead) != 0;
+#endif
+    for (; i < n; i++) {
+        vx[i] = vx[i]*damping + dvx;
+        vy[i] = vy[i]*damping + dvy;
+        vz[i] = vz[i]*damping + dvz;
+        px[i] += vx[i]*dt;
+        py[i] += vy[i]*dt;
+        pz[i] += vz[i]*dt;
+        l[i] -= dt;
+        dead = dead || l[i] <= 0 || px[i] < 0 || py[i] < 0 || pz[i] < 0
+                    || px[i] >= width || py[i] >= height || pz[i] >= depth;
+    }
+    if (!dead) {
+        return;
+    }
+
+    // the last particle takes the place of a dead one, and is looked at next
+    i = 0;
+    while (i < n) {
+        bool expiredHere = l[i] <= 0;
+        if (!expiredHere && px[i] >= 0 && py[i] >= 0 && pz[i] >= 0
+                && px[i] < width && py[i] < height && pz[i] < depth) {
+            i++;
+            continue;
+        }
+        if (expiredHere && expired) {
+            Vector3 p = { px[i], py[i], pz[i] };
+            expired->push_back(p);
+        }
+        n--;
+        px[i] = px[n];
+        py[i] = py[n];
+        pz[i] = pz[n];
+        vx[i] = vx[n];
+        vy[i] = vy[n];
+        vz[i] = vz[n];
+        l[i] = l[n];
+    }
+}
+
+void ParticleSystem::rasterize(BitPlane& plane) const {
+    // update() keeps everything inside the bounds, spawn() doesn't
+    int w = plane.width(), h = plane.height(), d = plane.depth();
+    BitPlane::Word* words = plane.data();
+    for (int i = 0; i < n; i++) {
+        int x = (int) px[i], y = (int) py[i], z = (int) pz[i];
+        if (x >= 0 && y >= 0 && z >= 0 && x < w && y < h && z < d) {
+            int bit = (x*h + y)*d + z;
+            words[bit >> 6] |= (BitPlane::Word) 1 << (bit & 63);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------
+
+ParticleLayer::ParticleLayer(int effect)
+    : effect(effect), w(0), h(0), d(0), last(-1), owed(0), state(2463534242u) {
+}
+
+std::string ParticleLayer::name() const {
+    switch (effect) {
+    case EFFECT_RAIN:      return "Rain";
+    case EFFECT_SNOW:      return "Snow";
+    default:               return "Fireworks";
+    }
+}
+
+void ParticleLayer::resize(int width, int height, int depth) {
+    w = width;
+    h = height;
+    d = depth;
+    particles.setBounds(w, h, d);
+    rockets.setBounds(w, h, d);
+    particles.clear();
+    rockets.clear();
+    last = -1;
+
+    // speeds are in cubes per second, so that every size looks about the same
+    Vector3 gravity = { 0, 0, 0 };
+    switch (effect) {
+    case EFFECT_RAIN:
+        // falling at their top speed already
+        particles.setGravity(gravity);
+        particles.setDrag(0);
+        break;
+    case EFFECT_SNOW:
+        particles.setGravity(gravity);
+        particles.setDrag(0.2f);
+        break;
+    case EFFECT_FIREWORKS:
+        gravity.y = -0.8f*h;
+        rockets.setGravity(gravity);
+        gravity.y = -0.3f*h;
+        particles.setGravity(gravity);
+        particles.setDrag(1.0f);
+        break;
+    }
+}
+
+float ParticleLayer::random() {
+    // xorshift32
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return (state >> 8) * (1.0f / 16777216.0f);
+}
+
+Vector3 ParticleLayer::randomDirection() {
+    Vector3 v;
+    float length;
+    do {
+        v.x = random()*2 - 1;
+        v.y = random()*2 - 1;
+        v.z = random()*2 - 1;
+        length = v.x*v.x + v.y*v.y + v.z*v.z;
+    } while (length > 1 || length < 1e-4f);
+    length = sqrt(length);
+    v.x /= length;
+    v.y /= length;
+    v.z /= length;
+    return v;
+}
+
+void ParticleLayer::addParticles(float dt) {
+    // particles per second, by the area they come down on
+    float rate;
+    switch (effect) {
+    case EFFECT_RAIN:      rate = 0.4f*w*d; break;
+    case EFFECT_SNOW:      rate = 0.08f*w*d; break;
+    default:               rate = 0.7f; break;
+    }
+    owed += rate*dt;
+    int count = (int) owed;
+    owed -= count;
+
+    for (int i = 0; i < count; i++) {
+        Vector3 p, v;
+        switch (effect) {
+        case EFFECT_RAIN:
+            p.x = random()*w;
+            p.y = h*(1 - 0.01f*random());
+            p.z = random()*d;
+            v.x = v.z = 0;
+            v.y = -1.2f*h*(0.8f + 0.4f*random());
+            particles.spawn(p, v, 10);
+            break;
+        case EFFECT_SNOW:
+            p.x = random()*w;
+            p.y = h*(1 - 0.01f*random());
+            p.z = random()*d;
+            v.x = (random() - 0.5f)*0.05f*w;
+            v.y = -0.2f*h*(0.8f + 0.4f*random());
+            v.z = (random() - 0.5f)*0.05f*d;
+            particles.spawn(p, v, 30);
+            break;
+        case EFFECT_FIREWORKS: {
+            // from the middle of the floor, going off at 60 to 90% of the height
+            p.x = w*(0.25f + 0.5f*random());
+            p.y = 0;
+            p.z = d*(0.25f + 0.5f*random());
+            float g = 0.8f*h;
+            float peak = h*(0.6f + 0.3f*random());
+            v.x = (random() - 0.5f)*0.1f*w;
+            v.y = sqrt(2*g*peak);
+            v.z = (random() - 0.5f)*0.1f*d;
+            rockets.spawn(p, v, v.y/g);
+            break;
+        }
+        }
+    }
+}
+
+void ParticleLayer::explode(const Vector3& position) {
+    // more sparks for bigger cubes, so that the ball looks as full
+    int sparks = 40 + w*h*d/200;
+    for (int i = 0; i < sparks; i++) {
+        Vector3 v = randomDirection();
+        float speed = 0.3f*h*(0.5f + 0.5f*random());
+        v.x *= speed;
+        v.y *= speed;
+        v.z *= speed;
+        if (!particles.spawn(position, v, 1.0f + 0.6f*random())) {
+            break;
+        }
+    }
+}
+
+void ParticleLayer::render(BitPlane& plane, int t) {
+    if (w == 0 || h == 0 || d == 0) {
+        return;
+    }
+    // the pools are only allocated for layers that are shown
+    if (particles.capacity() == 0) {
+        particles.setCapacity(MAX_PARTICLES);
+        rockets.setCapacity(effect == EFFECT_FIREWORKS ? 64 : 0);
+    }
+
+    // going back in time (an export starting at 0) starts over, and a
+    // long pause doesn't make everything jump. the other cubes of a
+    // wall show the particles as they are
+    if (last < 0 || t < last - RESTART_MS) {
+        particles.clear();
+        rockets.clear();
+        last = t;
+    }
+    if (t > last) {
+        float dt = std::min(0.1f, (t - last) / 1000.0f);
+        last = t;
+
+        addParticles(dt);
+        expired.clear();
+        rockets.update(dt, &expired);
+        for (size_t i = 0; i < expired.size(); i++) {
+            explode(expired[i]);
+        }
+        particles.update(dt);
+    }
+
+    particles.rasterize(plane);
+    rockets.rasterize(plane);
+}
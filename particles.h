@@ -0,0 +1,98 @@
+/*  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
+
+ > ParticleSystem class, a fixed pool of moving points, and the rain,
+ > snow and fireworks layers made out of it.
+
+ > Copyright (C) 2014 by Daniel Intskirveli, Gurpreet Singh, Christopher Zhang.
+
+ > particles.h - particle effects.
+
+ > Written by: Daniel Intskirveli, Gurpreet Singh, Christopher Zhang, 2014.
+
+  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_ */
+
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include <vector>
+#include "frustum.h"
+#include "compositor.h"
+
+//! Particles with a position, a velocity and a life time
+/*!
+    Every property is an array of its own, so that update() goes through
+    each of them in order, 4 particles at a time with SSE. The arrays are
+    allocated once by setCapacity(), spawn() and the particles dying never
+    allocate: a dead particle is replaced by the last one. Positions are
+    in LEDs, velocities in LEDs per second and life times in seconds.
+*/
+class ParticleSystem
+{
+public:
+    ParticleSystem();
+
+    void setCapacity(int particles);                        // drops all particles
+    int capacity() const { return (int) life.size(); }
+    int count() const { return n; }
+    void clear() { n = 0; }
+
+    // particles leaving [0, width) x [0, height) x [0, depth) die
+    void setBounds(int width, int height, int depth);
+    void setGravity(const Vector3& acceleration);
+    void setDrag(float perSecond);                          // velocity lost per second, 1 is about 63%
+
+    // false when the pool is full
+    bool spawn(const Vector3& position, const Vector3& velocity, float lifeTime);
+
+    // moves everything dt seconds ahead. the positions of the particles
+    // whose life ran out (not the ones that left the bounds) are added
+    // to expired, if it isn't 0
+    void update(float dt, std::vector<Vector3>* expired = 0);
+
+    // turns on the LED each particle is in
+    void rasterize(BitPlane& plane) const;
+
+private:
+    std::vector<float> px, py, pz;
+    std::vector<float> vx, vy, vz;
+    std::vector<float> life;
+    int n;
+    float width, height, depth;
+    Vector3 gravity;
+    float drag;
+};
+
+//! Rain, snow or fireworks
+class ParticleLayer : public Layer
+{
+public:
+    enum { EFFECT_RAIN, EFFECT_SNOW, EFFECT_FIREWORKS };
+
+    ParticleLayer(int effect);
+
+    std::string name() const;
+    bool isAnimated() const { return true; }
+    void resize(int width, int height, int depth);
+    void render(BitPlane& plane, int t);
+
+    int count() const { return particles.count() + rockets.count(); }
+
+private:
+    enum { MAX_PARTICLES = 1 << 20 };
+
+    void addParticles(float dt);                            // the ones born in the next dt seconds
+    void explode(const Vector3& position);
+    float random();                                         // 0 to 1
+    Vector3 randomDirection();
+
+    int effect;
+    ParticleSystem particles;
+    ParticleSystem rockets;                                 // fireworks that haven't gone off yet
+    std::vector<Vector3> expired;
+    int w, h, d;
+    int last;                                               // newest t simulated, -1 before the first
+    float owed;                                             // part of a particle that is still to be spawned
+    unsigned int state;                                     // of random()
+};
+
+#endif
@@ -0,0 +1,100 @@
+/*  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
+
+ > PluginLayer class, an animation from a shared library that fills in
+ > whole frames through the C interface in ledcube_plugin.h.
+
+ > Copyright (C) 2014 by Daniel Intskirveli, Gurpreet Singh, Christopher Zhang.
+
+ > plugins.cpp - loading animation plugins.
+
+ > Written by: Daniel Intskirveli, Gurpreet Singh, Christopher Zhang, 2014.
+
+  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_ */
+
+#include "plugins.h"
+#include <QLibrary>
+#include <QDir>
+
+PluginLayer::PluginLayer(QLibrary* library, const LEDcubePlugin* plugin)
+    : library(library), plugin(plugin), state(0) {
+    for (int n = 0; n < plugin->parameterCount; n++) {
+        parameters.push_back(plugin->parameterDefaults ? plugin->parameterDefaults[n] : 0);
+    }
+}
+
+PluginLayer::~PluginLayer() {
+    if (state && plugin->destroy) {
+        plugin->destroy(state);
+    }
+    library->unload();
+    delete library;
+}
+
+std::string PluginLayer::name() const {
+    return plugin->name ? plugin->name : "Plugin";
+}
+
+bool PluginLayer::isAnimated() const {
+    return (plugin->flags & LEDCUBE_PLUGIN_ANIMATED) != 0;
+}
+
+QString PluginLayer::parameterName(int n) const {
+    return plugin->parameterNames ? QString(plugin->parameterNames[n]) : QString::number(n);
+}
+
+void PluginLayer::resize(int width, int height, int depth) {
+    // the state is made for one size of the cube
+    if (state && plugin->destroy) {
+        plugin->destroy(state);
+    }
+    state = plugin->create ? plugin->create(width, height, depth) : 0;
+}
+
+void PluginLayer::renderBrightness(VoxelGrid& grid, int t) {
+    LEDcubeFrame frame;
+    frame.width = grid.width();
+    frame.height = grid.height();
+    frame.depth = grid.depth();
+    frame.t = t;
+    frame.leds = grid.data();
+    frame.parameters = parameters.empty() ? 0 : &parameters[0];
+    frame.parameterCount = parameters.size();
+    if (frame.leds) {
+        plugin->render(state, &frame);
+    }
+}
+
+std::vector<PluginLayer*> loadPlugins(const QString& directory, QStringList* errors) {
+    std::vector<PluginLayer*> layers;
+    QDir dir(directory);
+    QStringList names = dir.entryList(QDir::Files, QDir::Name);
+    for (int i = 0; i < names.count(); i++) {
+        QString path = dir.absoluteFilePath(names.at(i));
+        if (!QLibrary::isLibrary(path)) {
+            continue;
+        }
+
+        QLibrary* library = new QLibrary(path);
+        LEDcubePluginEntry entry = (LEDcubePluginEntry) library->resolve(LEDCUBE_PLUGIN_ENTRY);
+        const LEDcubePlugin* plugin = entry ? entry() : 0;
+        QString error;
+        if (!entry) {
+            error = library->errorString();
+        } else if (!plugin || !plugin->render) {
+            error = "no render function";
+        } else if (plugin->apiVersion > LEDCUBE_PLUGIN_API_VERSION) {
+            error = QString("needs version %1 of the plugin interface").arg(plugin->apiVersion);
+        }
+
+        if (!error.isEmpty()) {
+            if (errors) {
+                errors->append(path + ": " + error);
+            }
+            library->unload();
+            delete library;
+            continue;
+        }
+        layers.push_back(new PluginLayer(library, plugin));
+    }
+    return layers;
+}
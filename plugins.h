@@ -0,0 +1,60 @@
+/*  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
+
+ > PluginLayer class, an animation from a shared library that fills in
+ > whole frames through the C interface in ledcube_plugin.h.
+
+ > Copyright (C) 2014 by Daniel Intskirveli, Gurpreet Singh, Christopher Zhang.
+
+ > plugins.h - loading animation plugins.
+
+ > Written by: Daniel Intskirveli, Gurpreet Singh, Christopher Zhang, 2014.
+
+  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_ */
+
+#ifndef PLUGINS_H
+#define PLUGINS_H
+
+#include <QString>
+#include <QStringList>
+#include "compositor.h"
+#include "ledcube_plugin.h"
+
+QT_BEGIN_NAMESPACE
+class QLibrary;
+QT_END_NAMESPACE
+
+//! Layer drawn by a plugin
+/*!
+    The plugin gets the whole grid of brightness values per frame, so
+    there is one call across the library boundary per frame, not one
+    per LED.
+*/
+class PluginLayer : public Layer
+{
+public:
+    // takes ownership of the library, which has to stay loaded as long as plugin is used
+    PluginLayer(QLibrary* library, const LEDcubePlugin* plugin);
+    ~PluginLayer();
+
+    std::string name() const;
+    bool isAnimated() const;
+    bool hasBrightness() const { return true; }
+    void resize(int width, int height, int depth);
+    void renderBrightness(VoxelGrid& grid, int t);
+
+    int parameterCount() const { return (int) parameters.size(); }
+    QString parameterName(int n) const;
+    void setParameter(int n, float value) { parameters[n] = value; }
+
+private:
+    QLibrary* library;
+    const LEDcubePlugin* plugin;
+    void* state;                                            // what plugin->create() returned
+    std::vector<float> parameters;
+};
+
+// loads every plugin in the directory. libraries that aren't plugins or
+// need a newer version of the interface are skipped with a line in errors
+std::vector<PluginLayer*> loadPlugins(const QString& directory, QStringList* errors);
+
+#endif
@@ -0,0 +1,56 @@
+/*  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
+
+ > Example animation plugin: a sphere around the center of the cube that
+ > grows and shrinks, brightest on its surface.
+
+ > Copyright (C) 2014 by Daniel Intskirveli, Gurpreet Singh, Christopher Zhang.
+
+ > sphere.c - plugin showing how to use ledcube_plugin.h.
+
+ > Written by: Daniel Intskirveli, Gurpreet Singh, Christopher Zhang, 2014.
+
+  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_ */
+
+#include <math.h>
+#include "ledcube_plugin.h"
+
+static const char* const parameterNames[] = { "period", "thickness" };
+static const float parameterDefaults[] = { 2000, 1.5f };
+
+static void render(void* state, LEDcubeFrame* frame) {
+    float period = frame->parameters[0] > 0 ? frame->parameters[0] : 1;
+    float thickness = frame->parameters[1] > 0 ? frame->parameters[1] : 1;
+    float cx = (frame->width - 1) / 2.0f;
+    float cy = (frame->height - 1) / 2.0f;
+    float cz = (frame->depth - 1) / 2.0f;
+    float largest = (float) sqrt(cx*cx + cy*cy + cz*cz);
+    float radius = largest * (float) (0.5 - 0.5*cos(6.2831853 * fmod((double) frame->t, period) / period));
+    unsigned char* led = frame->leds;
+    int x, y, z;
+    (void) state;
+
+    for (x = 0; x < frame->width; x++) {
+        for (y = 0; y < frame->height; y++) {
+            float dxy = (x - cx)*(x - cx) + (y - cy)*(y - cy);
+            for (z = 0; z < frame->depth; z++, led++) {
+                float off = (float) fabs(sqrt(dxy + (z - cz)*(z - cz)) - radius) / thickness;
+                if (off < 1) {
+                    *led = (unsigned char) (255*(1 - off));
+                }
+            }
+        }
+    }
+}
+
+static const LEDcubePlugin plugin = {
+    LEDCUBE_PLUGIN_API_VERSION,
+    "Pulsing Sphere",
+    LEDCUBE_PLUGIN_ANIMATED,
+    2, parameterNames, parameterDefaults,
+    0, 0,
+    render
+};
+
+LEDCUBE_PLUGIN_EXPORT const LEDcubePlugin* ledcube_plugin(void) {
+    return &plugin;
+}
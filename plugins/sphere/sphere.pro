@@ -0,0 +1,17 @@
+######################################################################
+# Example animation plugin, see ledcube_plugin.h.
+# Build with: cd plugins/sphere && qmake && make
+######################################################################
+QT -= core gui
+CONFIG += plugin
+CONFIG -= qt
+TEMPLATE = lib
+TARGET = sphere
+DESTDIR = ..
+DEPENDPATH += . ../..
+INCLUDEPATH += . ../..
+LIBS += -lm
+
+# Input
+HEADERS += ../../ledcube_plugin.h
+SOURCES += sphere.c
@@ -0,0 +1,311 @@
+/*  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
+
+ > SequenceLayer class which plays back a directory of .xyz files, one
+ > file per frame, loading and voxelizing frames ahead of time.
+
+ > Copyright (C) 2014 by Daniel Intskirveli, Gurpreet Singh, Christopher Zhang.
+
+ > sequence.cpp - streaming point cloud animations.
+
+ > Written by: Daniel Intskirveli, Gurpreet Singh, Christopher Zhang, 2014.
+
+  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_ */
+
+#include "sequence.h"
+#include "layers.h"
+#include "animations.h"
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QMap>
+#include <QDir>
+#include <QStringList>
+#include <algorithm>
+#include <cmath>
+
+// a frame for one of the loaders to read and voxelize
+struct SequenceJob {
+    int frame;
+    int generation;
+    QString file;
+    int width, height, depth;
+    Vector3 min, max;
+};
+
+//! The frames coming up next, shared by render() and the loaders
+/*!
+    The cache holds up to capacity frames starting at the current one,
+    wrapping around at the end of the sequence. Everything is guarded by
+    the mutex. generation changes whenever frames that are being loaded
+    would come out wrong (another sequence or another size of the cube),
+    the loaders throw those away when they are done.
+*/
+class SequenceCache
+{
+public:
+    SequenceCache() : width(0), height(0), depth(0), generation(0),
+                      current(0), capacity(32), late(0), stopping(false) {}
+
+    // blocks until there is a frame to load, returns false when the loaders should stop
+    bool take(SequenceJob& job) {
+        QMutexLocker locker(&mutex);
+        forever {
+            if (stopping) {
+                return false;
+            }
+            int count = files.count();
+            for (int i = 0; i < capacity && i < count && width > 0; i++) {
+                int frame = (current + i) % count;
+                if (!frames.contains(frame) && !loading.contains(frame)) {
+                    loading.append(frame);
+                    job.frame = frame;
+                    job.generation = generation;
+                    job.file = files.at(frame);
+                    job.width = width;
+                    job.height = height;
+                    job.depth = depth;
+                    job.min = min;
+                    job.max = max;
+                    return true;
+                }
+            }
+            wanted.wait(&mutex);
+        }
+    }
+
+    void finish(const SequenceJob& job, const BitPlane& plane) {
+        QMutexLocker locker(&mutex);
+        if (job.generation == generation) {
+            loading.removeAll(job.frame);
+            if (isWanted(job.frame)) {
+                frames.insert(job.frame, plane);
+            }
+        }
+    }
+
+    // called with the mutex locked: drop everything, the frames need loading again
+    void restart() {
+        generation++;
+        frames.clear();
+        loading.clear();
+        wanted.wakeAll();
+    }
+
+    // called with the mutex locked: drop the frames that are behind the current one
+    void evict() {
+        QList<int> keys = frames.keys();
+        for (int i = 0; i < keys.count(); i++) {
+            if (!isWanted(keys.at(i))) {
+                frames.remove(keys.at(i));
+            }
+        }
+        wanted.wakeAll();
+    }
+
+    bool isWanted(int frame) const {
+        int count = files.count();
+        return count > 0 && (frame - current + count) % count < capacity;
+    }
+
+    QMutex mutex;
+    QWaitCondition wanted;                                  // a frame needs loading, or stopping
+    QStringList files;
+    Vector3 min, max;                                       // bounds of the first frame
+    int width, height, depth;
+    int generation;
+    int current;                                            // frame on display
+    int capacity;
+    int late;
+    bool stopping;
+    QMap<int, BitPlane> frames;                             // ready to be shown
+    QList<int> loading;                                     // being loaded by one of the loaders
+};
+
+//! Reads and voxelizes frames until the cache is full
+class SequenceLoader : public QThread
+{
+public:
+    SequenceLoader(SequenceCache* cache) : cache(cache) {}
+
+protected:
+    void run() {
+        SequenceJob job;
+        std::vector<Vector3> points;
+        BitPlane plane;
+        while (cache->take(job)) {
+            // a file that can't be read is an empty frame
+            points.clear();
+            loadXYZ(job.file, points);
+            normalizePoints(points, job.min, job.max, job.width, job.height, job.depth);
+            plane.resize(job.width, job.height, job.depth);
+            rasterizePoints(plane, points);
+            cache->finish(job, plane);
+        }
+    }
+
+private:
+    SequenceCache* cache;
+};
+
+SequenceLayer::SequenceLayer() : fps(30), start(-1), last(-1), oldest(-1), rounds(0) {
+    cache = new SequenceCache;
+}
+
+SequenceLayer::~SequenceLayer() {
+    {
+        QMutexLocker locker(&cache->mutex);
+        cache->stopping = true;
+        cache->wanted.wakeAll();
+    }
+    for (int i = 0; i < loaders.count(); i++) {
+        loaders.at(i)->wait();
+        delete loaders.at(i);
+    }
+    delete cache;
+}
+
+int SequenceLayer::open(const QString& directory) {
+    QDir dir(directory);
+    QStringList names = dir.entryList(QStringList() << "*.xyz", QDir::Files, QDir::Name);
+    QStringList files;
+    for (int i = 0; i < names.count(); i++) {
+        files.append(dir.absoluteFilePath(names.at(i)));
+    }
+
+    // the first frame sets the scale of the whole sequence
+    std::vector<Vector3> points;
+    if (!files.isEmpty()) {
+        loadXYZ(files.at(0), points);
+    }
+    Vector3 min, max;
+    pointBounds(points, min, max);
+
+    {
+        QMutexLocker locker(&cache->mutex);
+        cache->files = files;
+        cache->min = min;
+        cache->max = max;
+        cache->current = 0;
+        cache->late = 0;
+        cache->restart();
+    }
+    start = -1;
+    last = -1;
+    shown.clear();
+
+    // one loader per core that's left over, the display needs one
+    if (loaders.isEmpty()) {
+        int count = std::max(1, QThread::idealThreadCount() - 1);
+        for (int i = 0; i < count; i++) {
+            SequenceLoader* loader = new SequenceLoader(cache);
+            loader->start();
+            loaders.append(loader);
+        }
+    }
+    return files.count();
+}
+
+void SequenceLayer::setFps(double framesPerSecond) {
+    fps = std::max(1.0, framesPerSecond);
+    start = -1;
+}
+
+void SequenceLayer::setCacheSize(int frames) {
+    QMutexLocker locker(&cache->mutex);
+    cache->capacity = std::max(1, frames);
+    cache->evict();
+}
+
+int SequenceLayer::frameCount() const {
+    QMutexLocker locker(&cache->mutex);
+    return cache->files.count();
+}
+
+int SequenceLayer::lateFrames() const {
+    QMutexLocker locker(&cache->mutex);
+    return cache->late;
+}
+
+void SequenceLayer::resize(int width, int height, int depth) {
+    QMutexLocker locker(&cache->mutex);
+    cache->width = width;
+    cache->height = height;
+    cache->depth = depth;
+    cache->restart();
+    shown.clear();
+}
+
+void SequenceLayer::render(BitPlane& plane, int t) {
+    const ShownFrame* source = 0;
+    {
+        QMutexLocker locker(&cache->mutex);
+        int count = cache->files.count();
+        if (count == 0) {
+            return;
+        }
+
+        // going back in time (an export starting at 0) starts over
+        if (start < 0 || t < last - RESTART_MS) {
+            start = t;
+            last = -1;
+            shown.clear();
+        }
+        int frame = (int) floor((t - start) * fps / 1000) % count;
+        if (frame < 0) {
+            frame += count;
+        }
+
+        if (t > last) {
+            // a new frame. the shown frames that no cube needs anymore
+            // are the ones the oldest cube is past and that weren't used
+            int before = oldest;
+            QMap<int, ShownFrame>::iterator it = shown.begin();
+            while (it != shown.end()) {
+                if (it.value().until < before && it.value().used < rounds) {
+                    it = shown.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            last = t;
+            oldest = t;
+            rounds++;
+
+            // move the window of the cache along, the loaders
+            // start on the frames that just came into it
+            if (frame != cache->current) {
+                cache->current = frame;
+                cache->evict();
+                if (!cache->frames.contains(frame)) {
+                    cache->late++;
+                }
+            }
+        }
+        oldest = std::min(oldest, t);
+
+        if (!shown.contains(frame) && cache->frames.contains(frame)) {
+            ShownFrame& f = shown[frame];
+            f.plane = cache->frames.value(frame);
+            f.until = t;
+        }
+
+        // a late frame keeps the one before it up, the
+        // last one of the sequence when it starts over
+        QMap<int, ShownFrame>::iterator it = shown.upperBound(frame);
+        if (it != shown.begin()) {
+            --it;
+        } else if (!shown.isEmpty()) {
+            it = shown.end();
+            --it;
+        }
+        if (it != shown.end()) {
+            it.value().until = std::max(it.value().until, t);
+            it.value().used = rounds;
+            source = &it.value();
+        }
+    }
+    // only render() changes shown, the copy doesn't need the lock
+    if (source && source->plane.wordCount() == plane.wordCount()) {
+        std::copy(source->plane.data(), source->plane.data() + source->plane.wordCount(), plane.data());
+    }
+}
@@ -0,0 +1,74 @@
+/*  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
+
+ > SequenceLayer class which plays back a directory of .xyz files, one
+ > file per frame, loading and voxelizing frames ahead of time.
+
+ > Copyright (C) 2014 by Daniel Intskirveli, Gurpreet Singh, Christopher Zhang.
+
+ > sequence.h - streaming point cloud animations.
+
+ > Written by: Daniel Intskirveli, Gurpreet Singh, Christopher Zhang, 2014.
+
+  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_ */
+
+#ifndef SEQUENCE_H
+#define SEQUENCE_H
+
+#include <QString>
+#include <QList>
+#include <QMap>
+#include "compositor.h"
+
+class SequenceCache;
+class SequenceLoader;
+
+//! Point cloud animation streamed from disk
+/*!
+    Loader threads read and voxelize the frames that come next into a
+    cache of a fixed number of frames, so that render() only copies a
+    ready BitPlane. When a frame isn't ready in time the previous one
+    stays up and the frame is counted as late, render() never waits for
+    the disk. On a wall that is shifted in time only the newest t moves
+    the cache along, the cubes behind it show frames that were on
+    display before. All frames are scaled with the bounds of the first one,
+    so that the animation doesn't wobble from frame to frame.
+*/
+class SequenceLayer : public Layer
+{
+public:
+    SequenceLayer();
+    ~SequenceLayer();
+
+    std::string name() const { return "Point Cloud Sequence"; }
+    bool isAnimated() const { return true; }
+    void resize(int width, int height, int depth);
+    void render(BitPlane& plane, int t);
+
+    // plays the .xyz files of the directory in the order of their
+    // names, starting with the next render(). returns the frame count
+    int open(const QString& directory);
+    void setFps(double fps);
+    void setCacheSize(int frames);
+
+    int frameCount() const;
+    int lateFrames() const;                                 // frames that weren't loaded in time
+
+private:
+    // a frame on display on one of the cubes of a wall
+    struct ShownFrame {
+        BitPlane plane;
+        int until;                                          // newest t it was shown at
+        int used;                                           // round it was last shown in
+    };
+
+    SequenceCache* cache;
+    QList<SequenceLoader*> loaders;
+    double fps;
+    int start;                                              // t of the first frame, -1 until it is shown
+    int last;                                               // newest t rendered, -1 before the first
+    int oldest;                                             // oldest t rendered since last moved on
+    int rounds;                                             // times last moved on
+    QMap<int, ShownFrame> shown;                            // by frame index
+};
+
+#endif
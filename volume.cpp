@@ -0,0 +1,317 @@
+/*  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
+
+ > VolumeRenderer class, keeps the LEDs in a 3D texture on the GPU and
+ > draws them by ray-marching it in a fragment shader.
+
+ > Copyright (C) 2014 by Daniel Intskirveli, Gurpreet Singh, Christopher Zhang.
+
+ > volume.cpp - LEDs drawn on the GPU.
+
+ > Written by: Daniel Intskirveli, Gurpreet Singh, Christopher Zhang, 2014.
+
+  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_ */
+
+#include "volume.h"
+#include <QGLShaderProgram>
+#include <cstring>
+
+// OpenGL 1.2, missing from some gl.h
+#ifndef GL_TEXTURE_3D
+#define GL_TEXTURE_3D                   0x806F
+#endif
+#ifndef GL_TEXTURE_WRAP_R
+#define GL_TEXTURE_WRAP_R               0x8072
+#endif
+#ifndef GL_MAX_3D_TEXTURE_SIZE
+#define GL_MAX_3D_TEXTURE_SIZE          0x8073
+#endif
+#ifndef GL_UNPACK_IMAGE_HEIGHT
+#define GL_UNPACK_IMAGE_HEIGHT          0x806E
+#endif
+#ifndef GL_CLAMP_TO_EDGE
+#define GL_CLAMP_TO_EDGE                0x812F
+#endif
+
+// points have a size in pixels, a ray hits them within this many LED
+// distances around their middle
+static const float POINT_SIZE = 0.2f;
+
+// the box around the cube. all positions the fragment shader gets are
+// in LED distances from its corner, so LED (x, y, z) starts at x, y, z
+static const char* vertexShader =
+    "#version 120\n"
+    "uniform vec3 boxMin;\n"
+    "uniform float delta;\n"
+    "varying vec3 position;\n"
+    "varying vec3 eye;\n"
+    "void main() {\n"
+    "    position = (gl_Vertex.xyz - boxMin) / delta;\n"
+    "    eye = ((gl_ModelViewMatrixInverse * vec4(0.0, 0.0, 0.0, 1.0)).xyz - boxMin) / delta;\n"
+    "    gl_Position = ftransform();\n"
+    "}\n";
+
+// only the back faces of the box are drawn, so that every pixel is
+// drawn once even when the camera is inside the cube. the ray from the
+// camera enters the box somewhere in front of that, and then goes from
+// one LED cell to the next (Amanatides & Woo). a LED that is on fills
+// only part of its cell, so the ray is tested against the LED itself.
+// the vertex arrays blend the front and the back of a cube, faces is
+// how many times a LED that is hit is blended. t is measured along
+// position - eye everywhere.
+static const char* fragmentShader =
+    "#version 120\n"
+    "uniform sampler3D leds;\n"
+    "uniform vec3 cells;\n"
+    "uniform float size;\n"
+    "uniform float transparency;\n"
+    "uniform float offAlpha;\n"
+    "uniform float faces;\n"
+    "varying vec3 position;\n"
+    "varying vec3 eye;\n"
+    "void main() {\n"
+    "    vec3 dir = position - eye;\n"
+    "    dir = mix(dir, vec3(1e-6), vec3(lessThan(abs(dir), vec3(1e-6))));\n"
+    "    vec3 inv = 1.0 / dir;\n"
+    "    vec3 t0 = -eye * inv;\n"
+    "    vec3 t1 = (cells - 1.0 + size - eye) * inv;\n"
+    "    vec3 enter = min(t0, t1);\n"
+    "    float t = max(max(max(enter.x, enter.y), enter.z), 0.0);\n"
+    "    vec3 cell = clamp(floor(eye + dir*t), vec3(0.0), cells - 1.0);\n"
+    "    vec3 stepDir = sign(dir);\n"
+    "    vec3 tDelta = abs(inv);\n"
+    "    vec3 tNext = (cell + max(stepDir, 0.0) - eye) * inv;\n"
+    "    float alpha = 0.0;\n"
+    "    for (int i = 0; i < %1; i++) {\n"
+    "        float value = texture3D(leds, (cell.zyx + 0.5) / cells.zyx).r;\n"
+    "        float a = value > 0.0 ? transparency + (1.0 - transparency)*value : offAlpha;\n"
+    "        if (a > 0.0) {\n"
+    "            vec3 l0 = (cell - eye) * inv;\n"
+    "            vec3 l1 = (cell + size - eye) * inv;\n"
+    "            vec3 lo = min(l0, l1);\n"
+    "            vec3 hi = max(l0, l1);\n"
+    "            if (max(max(max(lo.x, lo.y), lo.z), 0.0) <= min(min(hi.x, hi.y), hi.z)) {\n"
+    "                alpha += (1.0 - alpha)*(1.0 - pow(1.0 - a, faces));\n"
+    "                if (alpha > 0.99) {\n"
+    "                    break;\n"
+    "                }\n"
+    "            }\n"
+    "        }\n"
+    "        if (tNext.x < tNext.y && tNext.x < tNext.z) {\n"
+    "            cell.x += stepDir.x;\n"
+    "            tNext.x += tDelta.x;\n"
+    "        } else if (tNext.y < tNext.z) {\n"
+    "            cell.y += stepDir.y;\n"
+    "            tNext.y += tDelta.y;\n"
+    "        } else {\n"
+    "            cell.z += stepDir.z;\n"
+    "            tNext.z += tDelta.z;\n"
+    "        }\n"
+    "        if (any(lessThan(cell, vec3(0.0))) || any(greaterThanEqual(cell, cells))) {\n"
+    "            break;\n"
+    "        }\n"
+    "    }\n"
+    "    if (alpha <= 0.0) {\n"
+    "        discard;\n"
+    "    }\n"
+    "    gl_FragColor = vec4(1.0, 1.0, 1.0, alpha);\n"
+    "}\n";
+
+VolumeRenderer::VolumeRenderer() : program(0), texImage3D(0), texSubImage3D(0), maxSize(0) {
+}
+
+VolumeRenderer::~VolumeRenderer() {
+    // the textures go away with the context
+    delete program;
+}
+
+bool VolumeRenderer::initialize() {
+    // a new context has none of the old textures
+    delete program;
+    program = 0;
+    textures.clear();
+
+    if (!(QGLFormat::openGLVersionFlags() & QGLFormat::OpenGL_Version_2_0)
+            || !QGLShaderProgram::hasOpenGLShaderPrograms()) {
+        return false;
+    }
+    const QGLContext* context = QGLContext::currentContext();
+    texImage3D = (TexImage3D) context->getProcAddress("glTexImage3D");
+    texSubImage3D = (TexSubImage3D) context->getProcAddress("glTexSubImage3D");
+    if (!texImage3D || !texSubImage3D) {
+        return false;
+    }
+    glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &maxSize);
+
+    // QGLShaderProgram prints the log if something doesn't compile
+    program = new QGLShaderProgram;
+    if (!program->addShaderFromSourceCode(QGLShader::Vertex, vertexShader)
+            || !program->addShaderFromSourceCode(QGLShader::Fragment, QString(fragmentShader).arg((int) MAX_STEPS))
+            || !program->link()) {
+        delete program;
+        program = 0;
+        return false;
+    }
+    return true;
+}
+
+bool VolumeRenderer::fits(int width, int height, int depth) const {
+    return program && width + height + depth <= MAX_STEPS
+        && width <= maxSize && height <= maxSize && depth <= maxSize;
+}
+
+void VolumeRenderer::resize(int count) {
+    for (int n = count; n < (int) textures.size(); n++) {
+        glDeleteTextures(1, &textures[n].id);
+    }
+    int old = textures.size();
+    textures.resize(count);
+    for (int n = old; n < count; n++) {
+        glGenTextures(1, &textures[n].id);
+        glBindTexture(GL_TEXTURE_3D, textures[n].id);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    }
+    glBindTexture(GL_TEXTURE_3D, 0);
+}
+
+void VolumeRenderer::invalidate() {
+    for (size_t n = 0; n < textures.size(); n++) {
+        textures[n].current = false;
+    }
+}
+
+int VolumeRenderer::update(int n, const VoxelGrid& leds, const std::vector<Brick>& bricks) {
+    Texture& texture = textures[n];
+    int w = leds.width(), h = leds.height(), d = leds.depth();
+    if (!program || w == 0 || h == 0 || d == 0) {
+        return 0;
+    }
+
+    // the texture is stored with z first like the grid, so its width is
+    // the depth of the cube. every brick is a box of the grid that the
+    // row length and image height pick out of the whole thing
+    glBindTexture(GL_TEXTURE_3D, texture.id);
+    glPushClientAttrib(GL_CLIENT_PIXEL_STORE_BIT);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    int uploaded;
+    if (texture.uploaded.width() != w || texture.uploaded.height() != h || texture.uploaded.depth() != d) {
+        texImage3D(GL_TEXTURE_3D, 0, GL_LUMINANCE8, d, h, w, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, leds.data());
+        texture.uploaded = leds;
+        uploaded = bricks.size();
+    } else {
+        // a brick is different if one of its rows is, its copy is
+        // brought up to date on the way
+        dirty.clear();
+        if (!texture.current) {
+            for (size_t b = 0; b < bricks.size(); b++) {
+                dirty.push_back(b);
+            }
+        } else {
+            for (size_t b = 0; b < bricks.size(); b++) {
+                const Brick& brick = bricks[b];
+                int length = brick.z1 - brick.z0;
+                bool different = false;
+                for (int x = brick.x0; x < brick.x1 && !different; x++) {
+                    for (int y = brick.y0; y < brick.y1 && !different; y++) {
+                        int i = leds.index(x, y, brick.z0);
+                        different = memcmp(leds.data() + i, texture.uploaded.data() + i, length) != 0;
+                    }
+                }
+                if (different) {
+                    dirty.push_back(b);
+                }
+            }
+        }
+        for (size_t k = 0; k < dirty.size(); k++) {
+            const Brick& brick = bricks[dirty[k]];
+            for (int x = brick.x0; x < brick.x1; x++) {
+                for (int y = brick.y0; y < brick.y1; y++) {
+                    int i = leds.index(x, y, brick.z0);
+                    memcpy(texture.uploaded.data() + i, leds.data() + i, brick.z1 - brick.z0);
+                }
+            }
+        }
+
+        // every call has a cost of its own, so when most of the
+        // cube is different it goes up in one piece
+        if (dirty.size()*2 > bricks.size()) {
+            texSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, d, h, w, GL_LUMINANCE, GL_UNSIGNED_BYTE, leds.data());
+        } else {
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, d);
+            glPixelStorei(GL_UNPACK_IMAGE_HEIGHT, h);
+            for (size_t k = 0; k < dirty.size(); k++) {
+                const Brick& brick = bricks[dirty[k]];
+                texSubImage3D(GL_TEXTURE_3D, 0, brick.z0, brick.y0, brick.x0,
+                              brick.z1 - brick.z0, brick.y1 - brick.y0, brick.x1 - brick.x0,
+                              GL_LUMINANCE, GL_UNSIGNED_BYTE, leds.data() + leds.index(brick.x0, brick.y0, brick.z0));
+            }
+        }
+        uploaded = dirty.size();
+    }
+    glPopClientAttrib();
+    glBindTexture(GL_TEXTURE_3D, 0);
+    texture.current = true;
+    return uploaded;
+}
+
+void VolumeRenderer::draw(int n, const LatticeGeometry& g, float transparency, bool drawOff) {
+    const Texture& texture = textures[n];
+    if (!program || !texture.current || g.delta <= 0) {
+        return;
+    }
+    int w = texture.uploaded.width(), h = texture.uploaded.height(), d = texture.uploaded.depth();
+
+    // the LEDs in LED distances: a cube starts at its corner, a point
+    // is in the middle of the box a ray has to go through to hit it
+    float size = g.points ? POINT_SIZE : g.ledSize / g.delta;
+    float offset = g.points ? -POINT_SIZE/2 : 0;
+    Vector3 min, max;
+    min.x = -g.xSize/2 + offset*g.delta;
+    min.y = -g.ySize/2 + offset*g.delta;
+    min.z = -g.zSize/2 + offset*g.delta;
+    max.x = min.x + (w - 1 + size)*g.delta;
+    max.y = min.y + (h - 1 + size)*g.delta;
+    max.z = min.z + (d - 1 + size)*g.delta;
+
+    // the quads of the box, counter-clockwise seen from outside
+    static const float corners[24][3] = {
+        {1, 1, 0}, {0, 1, 0}, {0, 1, 1}, {1, 1, 1},
+        {1, 0, 1}, {0, 0, 1}, {0, 0, 0}, {1, 0, 0},
+        {1, 1, 1}, {0, 1, 1}, {0, 0, 1}, {1, 0, 1},
+        {1, 0, 0}, {0, 0, 0}, {0, 1, 0}, {1, 1, 0},
+        {0, 1, 1}, {0, 1, 0}, {0, 0, 0}, {0, 0, 1},
+        {1, 1, 0}, {1, 1, 1}, {1, 0, 1}, {1, 0, 0}
+    };
+    float vertices[24*3];
+    for (int v = 0; v < 24; v++) {
+        vertices[v*3 + 0] = corners[v][0] ? max.x : min.x;
+        vertices[v*3 + 1] = corners[v][1] ? max.y : min.y;
+        vertices[v*3 + 2] = corners[v][2] ? max.z : min.z;
+    }
+
+    program->bind();
+    program->setUniformValue("leds", (GLint) 0);
+    program->setUniformValue("boxMin", min.x, min.y, min.z);
+    program->setUniformValue("delta", g.delta);
+    program->setUniformValue("cells", (GLfloat) w, (GLfloat) h, (GLfloat) d);
+    program->setUniformValue("size", size);
+    program->setUniformValue("transparency", transparency);
+    program->setUniformValue("offAlpha", drawOff ? transparency : 0.0f);
+    program->setUniformValue("faces", g.points ? 1.0f : 2.0f);
+    glBindTexture(GL_TEXTURE_3D, texture.id);
+
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_FRONT);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, vertices);
+    glDrawArrays(GL_QUADS, 0, 24);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glCullFace(GL_BACK);
+    glDisable(GL_CULL_FACE);
+
+    glBindTexture(GL_TEXTURE_3D, 0);
+    program->release();
+}
@@ -0,0 +1,87 @@
+/*  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
+
+ > VolumeRenderer class, keeps the LEDs in a 3D texture on the GPU and
+ > draws them by ray-marching it in a fragment shader.
+
+ > Copyright (C) 2014 by Daniel Intskirveli, Gurpreet Singh, Christopher Zhang.
+
+ > volume.h - LEDs drawn on the GPU.
+
+ > Written by: Daniel Intskirveli, Gurpreet Singh, Christopher Zhang, 2014.
+
+  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_ */
+
+#ifndef VOLUME_H
+#define VOLUME_H
+
+#include <QGLWidget>
+#include <vector>
+#include "lattice.h"
+
+class QGLShaderProgram;
+
+//! LEDs drawn by ray-marching a 3D texture
+/*!
+    The brightness of every LED is a texel of a 3D texture, so the CPU
+    doesn't turn LEDs into vertices at all. draw() puts a box around the
+    cube and the fragment shader follows the ray of every pixel through
+    it from one LED to the next, blending the ones that are on (or off
+    and translucent) the same way the vertex arrays are blended.
+
+    update() compares the LEDs with what was uploaded last time, brick
+    by brick, and only uploads the bricks that are different. The
+    texture is stored with z first, like the VoxelGrid, so that a brick
+    goes straight from the grid to glTexSubImage3D().
+
+    Everything needed is in OpenGL 2.0 (GLSL 1.20 and 3D textures),
+    which software renderers like Mesa's llvmpipe have as well.
+*/
+class VolumeRenderer
+{
+public:
+    VolumeRenderer();
+    ~VolumeRenderer();
+
+    // compiles the shaders, the GL context has to be current. false if
+    // there are no shaders or 3D textures, nothing is drawn then
+    bool initialize();
+    bool isSupported() const { return program != 0; }
+    bool fits(int width, int height, int depth) const;      // whether a texture can be that big
+
+    void resize(int count);                                 // number of textures, one per LatticeState
+    void invalidate();                                      // the next update() uploads everything
+    bool isCurrent(int n) const { return textures[n].current; }
+
+    // brings texture n up to date with the LEDs, returns the number of
+    // bricks that were uploaded
+    int update(int n, const VoxelGrid& leds, const std::vector<Brick>& bricks);
+
+    // draws texture n with the current modelview matrix, which has to
+    // put the cube where the vertex arrays would be
+    void draw(int n, const LatticeGeometry& geometry, float transparency, bool drawOff);
+
+private:
+    enum { MAX_STEPS = 1024 };                              // cells a ray may cross, at most width + height + depth
+
+    struct Texture {
+        GLuint id;
+        bool current;                                       // whether uploaded matches what the texture holds
+        VoxelGrid uploaded;                                 // copy of what was uploaded last time
+
+        Texture() : id(0), current(false) {}
+    };
+
+    typedef void (APIENTRY *TexImage3D)(GLenum, GLint, GLint, GLsizei, GLsizei, GLsizei, GLint, GLenum, GLenum,
+                                        const GLvoid*);
+    typedef void (APIENTRY *TexSubImage3D)(GLenum, GLint, GLint, GLint, GLint, GLsizei, GLsizei, GLsizei, GLenum,
+                                           GLenum, const GLvoid*);
+
+    QGLShaderProgram* program;
+    TexImage3D texImage3D;                                  // not in the OpenGL 1.1 headers of every platform
+    TexSubImage3D texSubImage3D;
+    GLint maxSize;                                          // of a 3D texture in each direction
+    std::vector<int> dirty;                                 // bricks update() uploads
+    std::vector<Texture> textures;
+};
+
+#endif
@@ -0,0 +1,80 @@
+/*  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
+
+ > VoxelGrid class holding the state of every LED in the cube, and
+ > VoxelPyramid, a set of coarser versions of a grid used for drawing
+ > large or far away cubes with less detail.
+
+ > Copyright (C) 2014 by Daniel Intskirveli, Gurpreet Singh, Christopher Zhang.
+
+ > voxelgrid.cpp - LED state storage and level of detail.
+
+ > Written by: Daniel Intskirveli, Gurpreet Singh, Christopher Zhang, 2014.
+
+  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_ */
+
+#include "voxelgrid.h"
+#include <algorithm>
+
+VoxelGrid::VoxelGrid() : w(0), h(0), d(0) {
+}
+
+void VoxelGrid::resize(int width, int height, int depth) {
+    w = width;
+    h = height;
+    d = depth;
+    values.assign((size_t) w*h*d, 0);
+}
+
+void VoxelGrid::fill(unsigned char value) {
+    std::fill(values.begin(), values.end(), value);
+}
+
+void VoxelPyramid::resize(int width, int height, int depth, int levels) {
+    grids.resize(levels);
+    for (int n = 0; n < levels; n++) {
+        grids[n].resize(width, height, depth);
+        // round up so the last, partly filled, block still gets a cell
+        width = (width + 1) / 2;
+        height = (height + 1) / 2;
+        depth = (depth + 1) / 2;
+    }
+}
+
+void VoxelPyramid::update(int x0, int y0, int z0, int x1, int y1, int z1, int maxLevel) {
+    maxLevel = std::min(maxLevel, levelCount() - 1);
+    for (int n = 1; n <= maxLevel; n++) {
+        const VoxelGrid& fine = grids[n - 1];
+        VoxelGrid& coarse = grids[n];
+
+        // the box in coordinates of this level
+        x0 /= 2;  y0 /= 2;  z0 /= 2;
+        x1 = (x1 + 1) / 2;
+        y1 = (y1 + 1) / 2;
+        z1 = (z1 + 1) / 2;
+
+        for (int x = x0; x < x1; x++) {
+            int fx1 = std::min(2*x + 2, fine.width());
+            for (int y = y0; y < y1; y++) {
+                int fy1 = std::min(2*y + 2, fine.height());
+                for (int z = z0; z < z1; z++) {
+                    int fz1 = std::min(2*z + 2, fine.depth());
+
+                    // average of the children that exist, cells
+                    // on the far edges of the cube have fewer than 8
+                    int sum = 0;
+                    int count = 0;
+                    for (int fx = 2*x; fx < fx1; fx++) {
+                        for (int fy = 2*y; fy < fy1; fy++) {
+                            const unsigned char* row = fine.data() + fine.index(fx, fy, 0);
+                            for (int fz = 2*z; fz < fz1; fz++) {
+                                sum += row[fz];
+                                count++;
+                            }
+                        }
+                    }
+                    coarse.setValue(x, y, z, (unsigned char) ((sum + count/2) / count));
+                }
+            }
+        }
+    }
+}
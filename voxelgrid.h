@@ -0,0 +1,77 @@
+/*  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
+
+ > VoxelGrid class holding the state of every LED in the cube, and
+ > VoxelPyramid, a set of coarser versions of a grid used for drawing
+ > large or far away cubes with less detail.
+
+ > Copyright (C) 2014 by Daniel Intskirveli, Gurpreet Singh, Christopher Zhang.
+
+ > voxelgrid.h - LED state storage and level of detail.
+
+ > Written by: Daniel Intskirveli, Gurpreet Singh, Christopher Zhang, 2014.
+
+  -_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_ */
+
+#ifndef VOXELGRID_H
+#define VOXELGRID_H
+
+#include <vector>
+
+//! State of every LED in the cube
+/*!
+    One brightness value per LED, 0 is off and 255 is fully on.
+    LEDs are stored in the same order paintGL() walks them: x is the
+    outer loop, z the inner one, so index(x, y, z + 1) == index(x, y, z) + 1.
+*/
+class VoxelGrid
+{
+public:
+    VoxelGrid();
+
+    void resize(int width, int height, int depth);
+    void fill(unsigned char value);
+
+    int width() const { return w; }
+    int height() const { return h; }
+    int depth() const { return d; }
+    int index(int x, int y, int z) const { return (x*h + y)*d + z; }
+
+    unsigned char value(int x, int y, int z) const { return values[index(x, y, z)]; }
+    void setValue(int x, int y, int z, unsigned char v) { values[index(x, y, z)] = v; }
+
+    unsigned char* data() { return values.empty() ? 0 : &values[0]; }
+    const unsigned char* data() const { return values.empty() ? 0 : &values[0]; }
+
+private:
+    int w;
+    int h;
+    int d;
+    std::vector<unsigned char> values;
+};
+
+//! Mip-pyramid of a VoxelGrid
+/*!
+    Level 0 is the full resolution grid, every following level halves the
+    resolution in each direction. A cell on level n is the average of the
+    (up to) 2x2x2 cells below it, so it holds the aggregated brightness of
+    the 2^n x 2^n x 2^n block of LEDs it covers.
+*/
+class VoxelPyramid
+{
+public:
+    void resize(int width, int height, int depth, int levels);
+
+    int levelCount() const { return (int) grids.size(); }
+    VoxelGrid& level(int n) { return grids[n]; }
+    const VoxelGrid& level(int n) const { return grids[n]; }
+
+    // recompute the coarse levels for the LEDs in [x0, x1) x [y0, y1) x [z0, z1)
+    // of level 0, up to and including level maxLevel. the box should be
+    // aligned to 2^maxLevel so that no coarse cell is only partly updated.
+    void update(int x0, int y0, int z0, int x1, int y1, int z1, int maxLevel);
+
+private:
+    std::vector<VoxelGrid> grids;
+};
+
+#endif
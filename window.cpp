@@ -62,10 +62,16 @@ Window::Window()
 
     drawOff = new QCheckBox("draw \"Off\" LEDs?");                  // create a checkbox for draw off LED's
     isCube = new QCheckBox("Keep dimensions cubic");                // create a checkbox for keeping cubic dimensions
+    levelOfDetail = new QCheckBox("Automatic level of detail");     // create a checkbox for drawing far away LEDs in blocks
+    levelOfDetail->setChecked(settings->value("levelOfDetail", true).toBool());
+    volumeRendering = new QCheckBox("Ray-march on the GPU");        // create a checkbox for drawing the LEDs from a 3D texture
+    volumeRendering->setChecked(settings->value("volumeRendering", false).toBool());
 
     // connect the checkboxs to slots of the widget
     connect(drawOff, SIGNAL(toggled(bool)), matrixWidget, SLOT(toggleDrawOff(bool)));
     connect(isCube, SIGNAL(toggled(bool)), this, SLOT(setCubicDimensions(bool)));        
+    connect(levelOfDetail, SIGNAL(toggled(bool)), matrixWidget, SLOT(setLevelOfDetail(bool)));
+    connect(volumeRendering, SIGNAL(toggled(bool)), matrixWidget, SLOT(setVolumeRendering(bool)));
 
     LEDStatus     = new QVBoxLayout;                                // vertical layout for the LED status
     Status        = new QLabel(tr("LED Status"));                   // lable for the led status
@@ -75,6 +81,8 @@ Window::Window()
     LEDStatus->addWidget(Status);                                   // add the widgets to the layout
     LEDStatus->addWidget(comboBox);
     LEDStatus->addWidget(drawOff);
+    LEDStatus->addWidget(levelOfDetail);
+    LEDStatus->addWidget(volumeRendering);
 
     resolutionLayout->addLayout(LEDStatus);                         // add the LED status layout to the resolution layout
 
@@ -163,22 +171,191 @@ Window::Window()
     Transforms = new QGroupBox(tr("Transformations"));              // transformations GroupBox
     Transforms->setLayout(transformsLayout);                        // transformations layout added to the Transforms GBox 
     settingsLayout->addWidget(Transforms);
+
+    QLabel* columnsLabel = new QLabel(tr("Columns"));               // cubes next to each other
+    QLabel* rowsLabel    = new QLabel(tr("Rows"));                  // cubes on top of each other
+    QLabel* gapLabel     = new QLabel(tr("Gap"));                   // LEDs between two cubes
+    QLabel* phaseLabel   = new QLabel(tr("Phase"));                 // animation delay from one cube to the next
+
+    QSpinBox* columnsSpinbox = createSpinBox();
+    QSpinBox* rowsSpinbox    = createSpinBox();
+    QSpinBox* gapSpinbox     = createSpinBox();
+    QSpinBox* phaseSpinbox   = createSpinBox();
+    columnsSpinbox->setRange(1, 16);
+    rowsSpinbox->setRange(1, 16);
+    gapSpinbox->setRange(0, 50);
+    phaseSpinbox->setRange(0, 1000);
+    phaseSpinbox->setSingleStep(10);
+    phaseSpinbox->setSuffix(tr(" ms"));
+    columnsSpinbox->setValue(settings->value("wallColumns", 1).toInt());
+    rowsSpinbox->setValue(settings->value("wallRows", 1).toInt());
+    gapSpinbox->setValue(settings->value("wallGap", 2).toInt());
+    phaseSpinbox->setValue(settings->value("wallPhase", 0).toInt());
+
+    QHBoxLayout* wallSizeLayout = new QHBoxLayout;                  // columns and rows next to each other
+    wallSizeLayout->addWidget(columnsLabel);
+    wallSizeLayout->addWidget(columnsSpinbox);
+    columnsLabel->setBuddy(columnsSpinbox);
+    wallSizeLayout->addWidget(rowsLabel);
+    wallSizeLayout->addWidget(rowsSpinbox);
+    rowsLabel->setBuddy(rowsSpinbox);
+
+    QHBoxLayout* wallSpacingLayout = new QHBoxLayout;               // gap and phase next to each other
+    wallSpacingLayout->addWidget(gapLabel);
+    wallSpacingLayout->addWidget(gapSpinbox);
+    gapLabel->setBuddy(gapSpinbox);
+    wallSpacingLayout->addWidget(phaseLabel);
+    wallSpacingLayout->addWidget(phaseSpinbox);
+    phaseLabel->setBuddy(phaseSpinbox);
+
+    QVBoxLayout* wallLayout = new QVBoxLayout;
+    wallLayout->addLayout(wallSizeLayout);
+    wallLayout->addLayout(wallSpacingLayout);
+
+    connect(columnsSpinbox, SIGNAL(valueChanged(int)), matrixWidget, SLOT(setWallColumns(int)));
+    connect(rowsSpinbox, SIGNAL(valueChanged(int)), matrixWidget, SLOT(setWallRows(int)));
+    connect(gapSpinbox, SIGNAL(valueChanged(int)), matrixWidget, SLOT(setWallGap(int)));
+    connect(phaseSpinbox, SIGNAL(valueChanged(int)), matrixWidget, SLOT(setWallPhase(int)));
+
+    QGroupBox* Wall = new QGroupBox(tr("Wall Layout"));              // wall of several cubes GroupBox
+    Wall->setLayout(wallLayout);
+    settingsLayout->addWidget(Wall);
     
+    QLabel* bitsLabel     = new QLabel(tr("Bits"));                // resolution of the simulated driver
+    QLabel* refreshLabel  = new QLabel(tr("Refresh"));             // refresh cycles per second
+    QLabel* exposureLabel = new QLabel(tr("Exposure"));            // time a frame integrates over
+
+    QComboBox* driverMode = new QComboBox;                          // the items are in the order of DriverSettings::MODE_
+    driverMode->addItem(tr("Show Brightness Directly"));
+    driverMode->addItem(tr("Bit Angle Modulation"));
+    driverMode->addItem(tr("PWM"));
+    QSpinBox* bitsSpinbox     = createSpinBox();
+    QSpinBox* refreshSpinbox  = createSpinBox();
+    QSpinBox* exposureSpinbox = createSpinBox();
+    bitsSpinbox->setRange(1, 8);
+    refreshSpinbox->setRange(1, 10000);
+    refreshSpinbox->setSuffix(tr(" Hz"));
+    exposureSpinbox->setRange(1, 1000);
+    exposureSpinbox->setSuffix(tr(" ms"));
+    QCheckBox* multiplex = new QCheckBox(tr("Multiplex Layers"));
+    driverMode->setCurrentIndex(settings->value("driverMode", DriverSettings::MODE_OFF).toInt());
+    bitsSpinbox->setValue(settings->value("driverBits", 8).toInt());
+    refreshSpinbox->setValue(settings->value("driverRefreshRate", 120).toInt());
+    exposureSpinbox->setValue(settings->value("driverExposure", 16).toInt());
+    multiplex->setChecked(settings->value("driverMultiplex", true).toBool());
+
+    QHBoxLayout* driverTimingLayout = new QHBoxLayout;              // refresh and exposure next to each other
+    driverTimingLayout->addWidget(refreshLabel);
+    driverTimingLayout->addWidget(refreshSpinbox);
+    refreshLabel->setBuddy(refreshSpinbox);
+    driverTimingLayout->addWidget(exposureLabel);
+    driverTimingLayout->addWidget(exposureSpinbox);
+    exposureLabel->setBuddy(exposureSpinbox);
+
+    QHBoxLayout* driverBitsLayout = new QHBoxLayout;                // bits and multiplexing next to each other
+    driverBitsLayout->addWidget(bitsLabel);
+    driverBitsLayout->addWidget(bitsSpinbox);
+    bitsLabel->setBuddy(bitsSpinbox);
+    driverBitsLayout->addWidget(multiplex);
+
+    QVBoxLayout* driverLayout = new QVBoxLayout;
+    driverLayout->addWidget(driverMode);
+    driverLayout->addLayout(driverBitsLayout);
+    driverLayout->addLayout(driverTimingLayout);
+
+    connect(driverMode, SIGNAL(currentIndexChanged(int)), matrixWidget, SLOT(setDriverMode(int)));
+    connect(bitsSpinbox, SIGNAL(valueChanged(int)), matrixWidget, SLOT(setDriverBits(int)));
+    connect(refreshSpinbox, SIGNAL(valueChanged(int)), matrixWidget, SLOT(setDriverRefreshRate(int)));
+    connect(exposureSpinbox, SIGNAL(valueChanged(int)), matrixWidget, SLOT(setDriverExposure(int)));
+    connect(multiplex, SIGNAL(toggled(bool)), matrixWidget, SLOT(setDriverMultiplex(bool)));
+
+    QGroupBox* Driver = new QGroupBox(tr("LED Driver"));            // simulated BAM / PWM refresh GroupBox
+    Driver->setLayout(driverLayout);
+    settingsLayout->addWidget(Driver);
+
     QVBoxLayout* modelLayout = new QVBoxLayout;           
 
-    QRadioButton* noAnimation       = new QRadioButton(tr("No Animation")); 
-    QRadioButton* waveAnimation     = new QRadioButton(tr("Wave Animation"));      
-    QRadioButton* faceAnimation     = new QRadioButton(tr("Draw Face"));      
+    // a checkbox and the way it is combined with the layers above for
+    // every animation layer, the first checked layer is the base
+    for (int n = 0; n < matrixWidget->layerCount(); n++) {
+        QCheckBox* enabled = new QCheckBox(matrixWidget->layerName(n));
+        enabled->setChecked(matrixWidget->isLayerEnabled(n));
+        QComboBox* op = new QComboBox;
+        op->addItem(tr("Or"), Compositor::OP_OR);
+        op->addItem(tr("And"), Compositor::OP_AND);
+        op->addItem(tr("Xor"), Compositor::OP_XOR);
+        op->addItem(tr("Mask"), Compositor::OP_MASK);
+        op->addItem(tr("Add"), Compositor::OP_ADD);
+        op->setCurrentIndex(op->findData(matrixWidget->layerOp(n)));
+
+        QHBoxLayout* layerLayout = new QHBoxLayout;
+        layerLayout->addWidget(enabled);
+        layerLayout->addWidget(op);
+        modelLayout->addLayout(layerLayout);
+        layerEnabled.append(enabled);
+        layerOp.append(op);
+
+        connect(enabled, SIGNAL(toggled(bool)), this, SLOT(updateLayer()));
+        connect(op, SIGNAL(currentIndexChanged(int)), this, SLOT(updateLayer()));
+    }
 
-    modelLayout->addWidget(noAnimation);                              
-    modelLayout->addWidget(waveAnimation);                              
-    modelLayout->addWidget(faceAnimation);                            
-    noAnimation->setChecked(true);
+    QLabel* sequenceFpsLabel = new QLabel(tr("Sequence Speed"));    // frames of the point cloud sequence per second
+    QSpinBox* sequenceFpsSpinbox = createSpinBox();
+    sequenceFpsSpinbox->setRange(1, 240);
+    sequenceFpsSpinbox->setSuffix(tr(" fps"));
+    sequenceFpsSpinbox->setValue(settings->value("sequenceFps", 30).toInt());
+    QHBoxLayout* sequenceLayout = new QHBoxLayout;
+    sequenceLayout->addWidget(sequenceFpsLabel);
+    sequenceLayout->addWidget(sequenceFpsSpinbox);
+    sequenceFpsLabel->setBuddy(sequenceFpsSpinbox);
+    modelLayout->addLayout(sequenceLayout);
+    connect(sequenceFpsSpinbox, SIGNAL(valueChanged(int)), matrixWidget, SLOT(setSequenceFps(int)));
+
+    QCheckBox* meshSolid = new QCheckBox(tr("Fill Mesh Model"));    // the inside of closed meshes as well as the surface
+    meshSolid->setChecked(settings->value("meshSolid", false).toBool());
+    modelLayout->addWidget(meshSolid);
+    connect(meshSolid, SIGNAL(toggled(bool)), matrixWidget, SLOT(setMeshSolid(bool)));
+
+    QLabel* automatonLabel = new QLabel(tr("Automaton Rule"));      // births / survivals by live neighbours, any B../S.. can be typed in
+    QComboBox* automatonRule = new QComboBox;
+    automatonRule->setEditable(true);
+    automatonRule->addItem("B6/S5-7");
+    automatonRule->addItem("B5/S4-5");
+    automatonRule->addItem("B4/S4");
+    automatonRule->addItem("B5-7/S6");
+    automatonRule->addItem("B6-7/S5-8");
+    automatonRule->setEditText(settings->value("automatonRule", "B6/S5-7").toString());
+    QHBoxLayout* automatonLayout = new QHBoxLayout;
+    automatonLayout->addWidget(automatonLabel);
+    automatonLayout->addWidget(automatonRule);
+    automatonLabel->setBuddy(automatonRule);
+    modelLayout->addLayout(automatonLayout);
+
+    QSpinBox* automatonSpeed = createSpinBox();
+    automatonSpeed->setRange(1, 240);
+    automatonSpeed->setSuffix(tr(" steps/s"));
+    automatonSpeed->setValue(settings->value("automatonSpeed", 10).toInt());
+    QCheckBox* automatonWrap = new QCheckBox(tr("Wrap Around"));
+    automatonWrap->setChecked(settings->value("automatonWrap", true).toBool());
+    QHBoxLayout* automatonSpeedLayout = new QHBoxLayout;
+    automatonSpeedLayout->addWidget(automatonSpeed);
+    automatonSpeedLayout->addWidget(automatonWrap);
+    modelLayout->addLayout(automatonSpeedLayout);
+
+    connect(automatonRule, SIGNAL(activated(const QString&)), matrixWidget, SLOT(setAutomatonRule(const QString&)));
+    connect(automatonSpeed, SIGNAL(valueChanged(int)), matrixWidget, SLOT(setAutomatonSpeed(int)));
+    connect(automatonWrap, SIGNAL(toggled(bool)), matrixWidget, SLOT(setAutomatonWrap(bool)));
+
+    audioLatency = new QLabel(tr("Audio Latency: -"));
+    modelLayout->addWidget(audioLatency);
+    QTimer* audioTimer = new QTimer(this);
+    connect(audioTimer, SIGNAL(timeout()), this, SLOT(updateAudioLatency()));
+    audioTimer->start(1000);
+
+    QPushButton* exportButton = new QPushButton(tr("Export Animation..."));
+    modelLayout->addWidget(exportButton);
+    connect(exportButton, SIGNAL(clicked()), this, SLOT(exportAnimation()));
 
-    connect(noAnimation,  SIGNAL(clicked(bool)), matrixWidget, SLOT(setNoAnimation(bool)));
-    connect(waveAnimation,    SIGNAL(clicked(bool)), matrixWidget, SLOT(setWaveAnimation(bool)));
-    connect(faceAnimation,   SIGNAL(clicked(bool)), matrixWidget, SLOT(setFaceAnimation(bool)));
-    
     QGroupBox *Animations = new QGroupBox(tr("3D Animations"));         
     Animations->setLayout(modelLayout);                    
     settingsLayout->addWidget(Animations);
@@ -205,6 +382,98 @@ Window::Window()
     makeConnections();                                              // make some connections
 }
 
+// render the animation offscreen and write it to disk
+bool Window::exportAnimation(const ExportSettings& settings, QString* error)
+{
+    return matrixWidget->exportAnimation(settings, error);
+}
+
+// export with the default settings to a file picked by the user
+void Window::exportAnimation()
+{
+    ExportSettings settings;
+    settings.path = QFileDialog::getSaveFileName(
+        this,
+        tr("Export Animation"),
+        QString(),
+        tr("Y4M video (*.y4m);;PNG sequence (*)")
+        );
+    if (settings.path.isEmpty()) {
+        return;
+    }
+    if (settings.path.endsWith(".y4m", Qt::CaseInsensitive)) {
+        settings.format = ExportSettings::FORMAT_Y4M;
+    }
+
+    QString error;
+    if (!exportAnimation(settings, &error)) {
+        QMessageBox::warning(this, tr("Export Animation"), error);
+    }
+}
+
+// pass a changed layer checkbox or op on to the widget
+void Window::updateLayer()
+{
+    for (int n = 0; n < layerEnabled.size(); n++) {
+        if (sender() == layerEnabled[n]) {
+            matrixWidget->setLayerEnabled(n, layerEnabled[n]->isChecked());
+        } else if (sender() == layerOp[n]) {
+            matrixWidget->setLayerOp(n, layerOp[n]->itemData(layerOp[n]->currentIndex()).toInt());
+        }
+    }
+}
+
+// how long the audio takes to show up in the frames, over the last second
+void Window::updateAudioLatency()
+{
+    double mean, max;
+    if (matrixWidget->audioLatency(mean, max) > 0) {
+        audioLatency->setText(tr("Audio Latency: %1 ms (max %2 ms)").arg(mean, 0, 'f', 1).arg(max, 0, 'f', 1));
+    } else {
+        audioLatency->setText(tr("Audio Latency: -"));
+    }
+}
+
+// plays a WAV file or stdin ("-") on the audio spectrum layer
+bool Window::openAudio(const QString& source)
+{
+    if (!matrixWidget->openAudio(source)) {
+        return false;
+    }
+    layerEnabled[MatrixWidget::LAYER_AUDIO]->setChecked(true);
+    return true;
+}
+
+// show only one of the animations, by name, as used on the command line
+bool Window::setAnimation(const QString& name)
+{
+    int layer;
+    if (name == "none") {
+        layer = MatrixWidget::LAYER_ALL_ON;
+    } else if (name == "wave") {
+        layer = MatrixWidget::LAYER_WAVE;
+    } else if (name == "face") {
+        layer = MatrixWidget::LAYER_FACE;
+    } else if (name == "gradient") {
+        layer = MatrixWidget::LAYER_GRADIENT;
+    } else {
+        // plugins go by the name they show up with
+        layer = -1;
+        for (int n = 0; n < matrixWidget->layerCount(); n++) {
+            if (matrixWidget->layerName(n).compare(name, Qt::CaseInsensitive) == 0) {
+                layer = n;
+            }
+        }
+        if (layer < 0) {
+            return false;
+        }
+    }
+    for (int n = 0; n < layerEnabled.size(); n++) {
+        layerEnabled[n]->setChecked(n == layer);
+    }
+    return true;
+}
+
 // utitlity function to create a slider
 QSlider *Window::createSlider(int min, int max, int singleStep, int pageStep, int tickInterval)
 {
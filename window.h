@@ -37,11 +37,17 @@ class Window : public QMainWindow
 
 public:
     Window();
+    bool exportAnimation(const ExportSettings& settings, QString* error);
+    bool setAnimation(const QString& name);
+    bool openAudio(const QString& source);
 
 public slots:
+	void exportAnimation();
 	void setSpacingSliderEnabled(bool enabled);
 	void setCubicDimensions(bool cubic);
 	void maybeSetAllDimensions(int value);
+	void updateLayer();
+	void updateAudioLatency();
 
 protected:
     void keyPressEvent(QKeyEvent *event);
@@ -58,6 +64,11 @@ private:
 
     QCheckBox* drawOff;
     QCheckBox* isCube;
+    QCheckBox* levelOfDetail;
+    QCheckBox* volumeRendering;
+    QList<QCheckBox*> layerEnabled;                                 // one checkbox and op per layer of the compositor
+    QList<QComboBox*> layerOp;
+    QLabel* audioLatency;                                           // of the audio spectrum layer, updated once a second
     QComboBox *comboBox;
     int drawMode;
     